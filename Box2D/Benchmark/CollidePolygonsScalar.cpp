@@ -0,0 +1,10 @@
+// The library's b2CollidePolygons built again with the scalar code paths, as
+// b2CollidePolygonsScalar. Kernels compares the manifolds of the SSE build
+// with these. Build this file with -ffp-contract=off, like the pragma in
+// b2CollidePolygon.cpp, so no multiply-add is fused in either.
+
+#if !defined(B2_NO_SIMD)
+#define B2_NO_SIMD
+#endif
+#define b2CollidePolygons b2CollidePolygonsScalar
+#include <Box2D/Collision/b2CollidePolygon.cpp>
@@ -0,0 +1,220 @@
+// Compares b2DistanceBatch and b2TimeOfImpactBatch against calling b2Distance
+// and b2TimeOfImpact once per pair. The shapes are allocated one by one and
+// picked at random, so the pairs reference memory scattered over the heap the
+// way the fixtures of a world do.
+
+#include <Box2D/Box2D.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static uint32 s_seed = 1;
+
+static float32 RandomFloat(float32 lo, float32 hi)
+{
+	s_seed = 1664525 * s_seed + 1013904223;
+	float32 r = float32(s_seed >> 8) / float32(1 << 24);
+	return lo + (hi - lo) * r;
+}
+
+static int32 RandomInt(int32 count)
+{
+	return b2Min(int32(RandomFloat(0.0f, float32(count))), count - 1);
+}
+
+static b2PolygonShape* CreatePolygon()
+{
+	int32 count = 3 + RandomInt(b2_maxPolygonVertices - 2);
+	b2Vec2 vertices[b2_maxPolygonVertices];
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 angle = 2.0f * b2_pi * i / count + RandomFloat(0.0f, 0.3f);
+		float32 radius = RandomFloat(0.3f, 2.0f);
+		vertices[i].Set(radius * cosf(angle), radius * sinf(angle));
+	}
+
+	b2PolygonShape* polygon = new b2PolygonShape;
+	polygon->Set(vertices, count);
+	return polygon;
+}
+
+static b2Sweep RandomSweep()
+{
+	b2Sweep sweep;
+	sweep.localCenter.SetZero();
+	sweep.c0.Set(RandomFloat(-5.0f, 5.0f), RandomFloat(-5.0f, 5.0f));
+	sweep.c = sweep.c0 + b2Vec2(RandomFloat(-8.0f, 8.0f), RandomFloat(-8.0f, 8.0f));
+	sweep.a0 = RandomFloat(-b2_pi, b2_pi);
+	sweep.a = sweep.a0 + RandomFloat(-2.0f, 2.0f);
+	sweep.alpha0 = 0.0f;
+	return sweep;
+}
+
+// Evict the pair data between runs so every run starts cold.
+static void FlushCaches()
+{
+	static char* buffer = NULL;
+	const int32 size = 32 << 20;
+	if (buffer == NULL)
+	{
+		buffer = new char[size];
+	}
+
+	for (int32 i = 0; i < size; i += 64)
+	{
+		++buffer[i];
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int32 shapeCount = 200000;
+	int32 pairCount = 200000;
+	int32 runs = 5;
+	if (argc > 1)
+	{
+		pairCount = atoi(argv[1]);
+		if (pairCount <= 0)
+		{
+			fprintf(stderr, "usage: %s [pairs], pairs must be positive\n", argv[0]);
+			return 2;
+		}
+	}
+
+	b2PolygonShape** shapes = new b2PolygonShape*[shapeCount];
+	for (int32 i = 0; i < shapeCount; ++i)
+	{
+		shapes[i] = CreatePolygon();
+	}
+
+	b2DistanceInput* distanceInputs = new b2DistanceInput[pairCount];
+	b2TOIInput* toiInputs = new b2TOIInput[pairCount];
+	for (int32 i = 0; i < pairCount; ++i)
+	{
+		b2DistanceInput* input = distanceInputs + i;
+		input->proxyA.Set(shapes[RandomInt(shapeCount)], 0);
+		input->proxyB.Set(shapes[RandomInt(shapeCount)], 0);
+		input->transformA.Set(b2Vec2(RandomFloat(-3.0f, 3.0f), RandomFloat(-3.0f, 3.0f)), RandomFloat(-b2_pi, b2_pi));
+		input->transformB.Set(b2Vec2(RandomFloat(-3.0f, 3.0f), RandomFloat(-3.0f, 3.0f)), RandomFloat(-b2_pi, b2_pi));
+		input->useRadii = true;
+
+		b2TOIInput* toiInput = toiInputs + i;
+		toiInput->proxyA.Set(shapes[RandomInt(shapeCount)], 0);
+		toiInput->proxyB.Set(shapes[RandomInt(shapeCount)], 0);
+		toiInput->sweepA = RandomSweep();
+		toiInput->sweepB = RandomSweep();
+		toiInput->tMax = 1.0f;
+	}
+
+	b2DistanceOutput* distanceOutputs = new b2DistanceOutput[pairCount];
+	b2DistanceOutput* batchDistanceOutputs = new b2DistanceOutput[pairCount];
+	b2SimplexCache* caches = new b2SimplexCache[pairCount];
+	b2SimplexCache* batchCaches = new b2SimplexCache[pairCount];
+	b2TOIOutput* toiOutputs = new b2TOIOutput[pairCount];
+	b2TOIOutput* batchToiOutputs = new b2TOIOutput[pairCount];
+
+	// Hardware counters are summed over all runs.
+	b2PerfCounters perfCounters;
+	perfCounters.Open();
+	b2HardwareCounters counters, delta;
+	b2HardwareCounters sums[4];
+	memset(sums, 0, sizeof(sums));
+
+	float32 distanceSingle = b2_maxFloat, distanceBatch = b2_maxFloat;
+	float32 toiSingle = b2_maxFloat, toiBatch = b2_maxFloat;
+	b2Timer timer;
+	for (int32 run = 0; run < runs; ++run)
+	{
+		memset(caches, 0, pairCount * sizeof(b2SimplexCache));
+		FlushCaches();
+		perfCounters.Read(&counters);
+		timer.Reset();
+		for (int32 i = 0; i < pairCount; ++i)
+		{
+			b2Distance(distanceOutputs + i, caches + i, distanceInputs + i);
+		}
+		distanceSingle = b2Min(distanceSingle, timer.GetMilliseconds());
+		perfCounters.ReadDelta(&delta, &counters);
+		b2AddCounters(sums + 0, delta);
+
+		memset(batchCaches, 0, pairCount * sizeof(b2SimplexCache));
+		FlushCaches();
+		perfCounters.Read(&counters);
+		timer.Reset();
+		b2DistanceBatch(batchDistanceOutputs, batchCaches, distanceInputs, pairCount);
+		distanceBatch = b2Min(distanceBatch, timer.GetMilliseconds());
+		perfCounters.ReadDelta(&delta, &counters);
+		b2AddCounters(sums + 1, delta);
+
+		FlushCaches();
+		perfCounters.Read(&counters);
+		timer.Reset();
+		for (int32 i = 0; i < pairCount; ++i)
+		{
+			b2TimeOfImpact(toiOutputs + i, toiInputs + i);
+		}
+		toiSingle = b2Min(toiSingle, timer.GetMilliseconds());
+		perfCounters.ReadDelta(&delta, &counters);
+		b2AddCounters(sums + 2, delta);
+
+		FlushCaches();
+		perfCounters.Read(&counters);
+		timer.Reset();
+		b2TimeOfImpactBatch(batchToiOutputs, toiInputs, pairCount);
+		toiBatch = b2Min(toiBatch, timer.GetMilliseconds());
+		perfCounters.ReadDelta(&delta, &counters);
+		b2AddCounters(sums + 3, delta);
+	}
+
+	int32 mismatches = 0;
+	for (int32 i = 0; i < pairCount; ++i)
+	{
+		if (distanceOutputs[i].distance != batchDistanceOutputs[i].distance ||
+			toiOutputs[i].state != batchToiOutputs[i].state || toiOutputs[i].t != batchToiOutputs[i].t)
+		{
+			++mismatches;
+		}
+	}
+
+	float32 toNanoseconds = 1000000.0f / pairCount;
+	printf("pairs: %d, best of %d runs\n", pairCount, runs);
+	printf("b2Distance       %8.1f ns/pair\n", distanceSingle * toNanoseconds);
+	printf("b2DistanceBatch  %8.1f ns/pair\n", distanceBatch * toNanoseconds);
+	printf("b2TimeOfImpact       %8.1f ns/pair\n", toiSingle * toNanoseconds);
+	printf("b2TimeOfImpactBatch  %8.1f ns/pair\n", toiBatch * toNanoseconds);
+	printf("mismatches: %d\n", mismatches);
+
+	if (perfCounters.IsOpen())
+	{
+		const char* names[4] = { "b2Distance", "b2DistanceBatch", "b2TimeOfImpact", "b2TimeOfImpactBatch" };
+		float64 perPair = 1.0 / (float64(pairCount) * runs);
+		printf("%-20s %10s %6s %10s %10s %10s  (per pair)\n", "", "cycles", "IPC", "L1D miss", "LLC miss", "br miss");
+		for (int32 i = 0; i < 4; ++i)
+		{
+			const b2HardwareCounters& c = sums[i];
+			printf("%-20s %10.1f %6.2f %10.2f %10.2f %10.2f\n", names[i],
+				c.cycles * perPair, c.cycles > 0 ? float64(c.instructions) / c.cycles : 0.0,
+				c.l1dMisses * perPair, c.llcMisses * perPair, c.branchMisses * perPair);
+		}
+	}
+	else
+	{
+		printf("hardware counters unavailable\n");
+	}
+
+	delete [] batchToiOutputs;
+	delete [] toiOutputs;
+	delete [] batchCaches;
+	delete [] caches;
+	delete [] batchDistanceOutputs;
+	delete [] distanceOutputs;
+	delete [] toiInputs;
+	delete [] distanceInputs;
+	for (int32 i = 0; i < shapeCount; ++i)
+	{
+		delete shapes[i];
+	}
+	delete [] shapes;
+
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,858 @@
+// Microbenchmarks for the hot kernels of the library: narrow phase collision,
+// distance and time of impact, the dynamic tree, the small object allocators
+// and the contact solver iterations. Inputs are random but seeded, so two runs
+// with the same seed time the same work.
+//
+// When the library uses SSE, b2CollidePolygons is first checked against the
+// scalar build of the same source, see CollidePolygonsScalar.cpp. Any manifold
+// that differs in a bit fails the run with exit code 2.
+//
+// Usage: Kernels [--seed n] [--reps n] [--filter substring] [--json file]
+
+#include <Box2D/Box2D.h>
+#include <Box2D/Dynamics/b2Island.h>
+#include <Box2D/Dynamics/Contacts/b2Contact.h>
+#include <Box2D/Dynamics/Contacts/b2ContactSolver.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct KernelResult
+{
+	const char* name;
+	int32 ops;				// operations per repetition
+	float64 bestNs;			// best repetition, per operation
+	float64 meanNs;			// mean over the repetitions, per operation
+	b2HardwareCounters counters;	// summed over the repetitions
+};
+
+static uint32 s_seed = 1;
+static int32 s_reps = 7;
+static b2PerfCounters s_perfCounters;
+
+// Results are folded into this so the compiler cannot drop the work.
+static volatile float32 s_sink;
+
+static float32 RandomFloat(float32 lo, float32 hi)
+{
+	s_seed = 1664525 * s_seed + 1013904223;
+	float32 r = float32(s_seed >> 8) / float32(1 << 24);
+	return lo + (hi - lo) * r;
+}
+
+static int32 RandomInt(int32 count)
+{
+	return b2Min(int32(RandomFloat(0.0f, float32(count))), count - 1);
+}
+
+static b2Transform RandomTransform(float32 extent)
+{
+	b2Transform xf;
+	xf.Set(b2Vec2(RandomFloat(-extent, extent), RandomFloat(-extent, extent)), RandomFloat(-b2_pi, b2_pi));
+	return xf;
+}
+
+static void RandomPolygon(b2PolygonShape* polygon)
+{
+	int32 count = 3 + RandomInt(b2_maxPolygonVertices - 2);
+	b2Vec2 vertices[b2_maxPolygonVertices];
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 angle = 2.0f * b2_pi * i / count + RandomFloat(0.0f, 0.3f);
+		float32 radius = RandomFloat(0.3f, 1.0f);
+		vertices[i].Set(radius * cosf(angle), radius * sinf(angle));
+	}
+	polygon->Set(vertices, count);
+}
+
+static b2AABB RandomAABB(float32 extent, float32 size)
+{
+	b2AABB aabb;
+	aabb.lowerBound.Set(RandomFloat(-extent, extent), RandomFloat(-extent, extent));
+	aabb.upperBound = aabb.lowerBound + b2Vec2(RandomFloat(0.1f, size), RandomFloat(0.1f, size));
+	return aabb;
+}
+
+// Times one repetition of a kernel. Begin and End bracket the timed region
+// so setup that must be redone per repetition stays outside.
+class KernelTimer
+{
+public:
+	KernelTimer(KernelResult* result, const char* name, int32 ops)
+	{
+		m_result = result;
+		m_result->name = name;
+		m_result->ops = ops;
+		m_result->bestNs = b2_maxFloat;
+		m_result->meanNs = 0.0;
+		memset(&m_result->counters, 0, sizeof(b2HardwareCounters));
+	}
+
+	void Begin()
+	{
+		s_perfCounters.Read(&m_counters);
+		m_timer.Reset();
+	}
+
+	void End()
+	{
+		float64 ns = float64(m_timer.GetNanoseconds()) / m_result->ops;
+		b2HardwareCounters delta;
+		s_perfCounters.ReadDelta(&delta, &m_counters);
+		b2AddCounters(&m_result->counters, delta);
+		m_result->bestNs = b2Min(m_result->bestNs, ns);
+		m_result->meanNs += ns / s_reps;
+	}
+
+private:
+	KernelResult* m_result;
+	b2Timer m_timer;
+	b2HardwareCounters m_counters;
+};
+
+static void CollidePolygons(KernelResult* result)
+{
+	const int32 count = 4096;
+	b2PolygonShape* polygons = new b2PolygonShape[2 * count];
+	b2Transform* transforms = new b2Transform[2 * count];
+	for (int32 i = 0; i < 2 * count; ++i)
+	{
+		RandomPolygon(polygons + i);
+		transforms[i] = RandomTransform(1.0f);
+	}
+
+	KernelTimer timer(result, "b2CollidePolygons", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		int32 points = 0;
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2Manifold manifold;
+			b2CollidePolygons(&manifold, polygons + 2 * i, transforms[2 * i], polygons + 2 * i + 1, transforms[2 * i + 1]);
+			points += manifold.pointCount;
+		}
+		timer.End();
+		s_sink += float32(points);
+	}
+
+	delete [] transforms;
+	delete [] polygons;
+}
+
+#if defined(B2_USE_SSE)
+void b2CollidePolygonsScalar(b2Manifold* manifold,
+							 const b2PolygonShape* polygonA, const b2Transform& xfA,
+							 const b2PolygonShape* polygonB, const b2Transform& xfB);
+
+static bool SameFloat(float32 a, float32 b)
+{
+	return memcmp(&a, &b, sizeof(float32)) == 0;
+}
+
+static bool SameVec2(const b2Vec2& a, const b2Vec2& b)
+{
+	return SameFloat(a.x, b.x) && SameFloat(a.y, b.y);
+}
+
+static bool SameManifold(const b2Manifold& a, const b2Manifold& b)
+{
+	if (a.pointCount != b.pointCount)
+	{
+		return false;
+	}
+
+	if (a.pointCount == 0)
+	{
+		return true;
+	}
+
+	if (a.type != b.type || !SameVec2(a.localNormal, b.localNormal) || !SameVec2(a.localPoint, b.localPoint))
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < a.pointCount; ++i)
+	{
+		if (!SameVec2(a.points[i].localPoint, b.points[i].localPoint) || a.points[i].id.key != b.points[i].id.key)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Compare the SSE manifolds with the scalar ones over seeded pairs, most of
+// them overlapping. Returns the number of pairs that differ.
+static int32 CheckCollidePolygons()
+{
+	const int32 count = 65536;
+	int32 mismatches = 0;
+	int32 touching = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2PolygonShape polygonA, polygonB;
+		RandomPolygon(&polygonA);
+		RandomPolygon(&polygonB);
+		b2Transform xfA = RandomTransform(1.0f);
+		b2Transform xfB = RandomTransform(1.0f);
+		if ((i & 7) == 0)
+		{
+			// Same pose, the shapes share vertices and normals.
+			xfB = xfA;
+		}
+
+		b2Manifold simd, scalar;
+		b2CollidePolygons(&simd, &polygonA, xfA, &polygonB, xfB);
+		b2CollidePolygonsScalar(&scalar, &polygonA, xfA, &polygonB, xfB);
+		touching += scalar.pointCount > 0 ? 1 : 0;
+		if (!SameManifold(simd, scalar))
+		{
+			if (mismatches == 0)
+			{
+				fprintf(stderr, "b2CollidePolygons: SSE and scalar manifolds differ at pair %d: %d points, normal (%.9g, %.9g) vs %d points, normal (%.9g, %.9g)\n",
+					i, simd.pointCount, simd.localNormal.x, simd.localNormal.y,
+					scalar.pointCount, scalar.localNormal.x, scalar.localNormal.y);
+			}
+			++mismatches;
+		}
+	}
+
+	printf("b2CollidePolygons: %d pairs, %d touching, %d SSE manifolds differ from the scalar ones\n",
+		count, touching, mismatches);
+	return mismatches;
+}
+#endif
+
+static void CollideCircles(KernelResult* result)
+{
+	const int32 count = 16384;
+	b2CircleShape* circles = new b2CircleShape[2 * count];
+	b2Transform* transforms = new b2Transform[2 * count];
+	for (int32 i = 0; i < 2 * count; ++i)
+	{
+		circles[i].m_radius = RandomFloat(0.2f, 1.0f);
+		circles[i].m_p.Set(RandomFloat(-0.5f, 0.5f), RandomFloat(-0.5f, 0.5f));
+		transforms[i] = RandomTransform(1.5f);
+	}
+
+	KernelTimer timer(result, "b2CollideCircles", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		int32 points = 0;
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2Manifold manifold;
+			b2CollideCircles(&manifold, circles + 2 * i, transforms[2 * i], circles + 2 * i + 1, transforms[2 * i + 1]);
+			points += manifold.pointCount;
+		}
+		timer.End();
+		s_sink += float32(points);
+	}
+
+	delete [] transforms;
+	delete [] circles;
+}
+
+static void CollideEdgeAndPolygon(KernelResult* result)
+{
+	const int32 count = 4096;
+	b2EdgeShape* edges = new b2EdgeShape[count];
+	b2PolygonShape* polygons = new b2PolygonShape[count];
+	b2Transform* transforms = new b2Transform[count];
+	for (int32 i = 0; i < count; ++i)
+	{
+		// Edges along the x axis with neighbors, as in a chain, and polygons
+		// resting on or near them.
+		b2Vec2 v1(RandomFloat(-2.0f, -0.5f), RandomFloat(-0.2f, 0.2f));
+		b2Vec2 v2(RandomFloat(0.5f, 2.0f), RandomFloat(-0.2f, 0.2f));
+		edges[i].Set(v1, v2);
+		edges[i].m_vertex0 = v1 + b2Vec2(-1.0f, RandomFloat(-0.3f, 0.3f));
+		edges[i].m_vertex3 = v2 + b2Vec2(1.0f, RandomFloat(-0.3f, 0.3f));
+		edges[i].m_hasVertex0 = true;
+		edges[i].m_hasVertex3 = true;
+
+		RandomPolygon(polygons + i);
+		transforms[i].Set(b2Vec2(RandomFloat(-1.5f, 1.5f), RandomFloat(0.0f, 1.0f)), RandomFloat(-b2_pi, b2_pi));
+	}
+
+	b2Transform identity;
+	identity.SetIdentity();
+
+	KernelTimer timer(result, "b2CollideEdgeAndPolygon", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		int32 points = 0;
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2Manifold manifold;
+			b2CollideEdgeAndPolygon(&manifold, edges + i, identity, polygons + i, transforms[i]);
+			points += manifold.pointCount;
+		}
+		timer.End();
+		s_sink += float32(points);
+	}
+
+	delete [] transforms;
+	delete [] polygons;
+	delete [] edges;
+}
+
+static void Distance(KernelResult* result)
+{
+	const int32 shapeCount = 1024;
+	const int32 count = 8192;
+	b2PolygonShape* polygons = new b2PolygonShape[shapeCount];
+	for (int32 i = 0; i < shapeCount; ++i)
+	{
+		RandomPolygon(polygons + i);
+	}
+
+	b2DistanceInput* inputs = new b2DistanceInput[count];
+	for (int32 i = 0; i < count; ++i)
+	{
+		inputs[i].proxyA.Set(polygons + RandomInt(shapeCount), 0);
+		inputs[i].proxyB.Set(polygons + RandomInt(shapeCount), 0);
+		inputs[i].transformA = RandomTransform(3.0f);
+		inputs[i].transformB = RandomTransform(3.0f);
+		inputs[i].useRadii = true;
+	}
+
+	KernelTimer timer(result, "b2Distance", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		float32 sum = 0.0f;
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2SimplexCache cache;
+			cache.count = 0;
+			b2DistanceOutput output;
+			b2Distance(&output, &cache, inputs + i);
+			sum += output.distance;
+		}
+		timer.End();
+		s_sink += sum;
+	}
+
+	delete [] inputs;
+	delete [] polygons;
+}
+
+static void TimeOfImpact(KernelResult* result)
+{
+	const int32 shapeCount = 1024;
+	const int32 count = 4096;
+	b2PolygonShape* polygons = new b2PolygonShape[shapeCount];
+	for (int32 i = 0; i < shapeCount; ++i)
+	{
+		RandomPolygon(polygons + i);
+	}
+
+	b2TOIInput* inputs = new b2TOIInput[count];
+	for (int32 i = 0; i < count; ++i)
+	{
+		b2TOIInput* input = inputs + i;
+		input->proxyA.Set(polygons + RandomInt(shapeCount), 0);
+		input->proxyB.Set(polygons + RandomInt(shapeCount), 0);
+
+		b2Sweep* sweeps[2] = { &input->sweepA, &input->sweepB };
+		for (int32 j = 0; j < 2; ++j)
+		{
+			b2Sweep* sweep = sweeps[j];
+			sweep->localCenter.SetZero();
+			sweep->c0.Set(RandomFloat(-5.0f, 5.0f), RandomFloat(-5.0f, 5.0f));
+			sweep->c = sweep->c0 + b2Vec2(RandomFloat(-8.0f, 8.0f), RandomFloat(-8.0f, 8.0f));
+			sweep->a0 = RandomFloat(-b2_pi, b2_pi);
+			sweep->a = sweep->a0 + RandomFloat(-2.0f, 2.0f);
+			sweep->alpha0 = 0.0f;
+		}
+		input->tMax = 1.0f;
+	}
+
+	KernelTimer timer(result, "b2TimeOfImpact", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		float32 sum = 0.0f;
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			b2TOIOutput output;
+			b2TimeOfImpact(&output, inputs + i);
+			sum += output.t;
+		}
+		timer.End();
+		s_sink += sum;
+	}
+
+	delete [] inputs;
+	delete [] polygons;
+}
+
+// Fixed size proxies scattered over a square, like the fixtures of a world.
+static const int32 s_treeProxyCount = 16384;
+static const float32 s_treeExtent = 200.0f;
+
+class TreeQueryCallback
+{
+public:
+	bool QueryCallback(int32 proxyId)
+	{
+		m_sum += proxyId;
+		return true;
+	}
+
+	float32 RayCastCallback(const b2RayCastInput& input, int32 proxyId)
+	{
+		m_sum += proxyId;
+		return input.maxFraction;
+	}
+
+	int32 m_sum;
+};
+
+static void TreeCreateProxy(KernelResult* result)
+{
+	b2AABB* aabbs = new b2AABB[s_treeProxyCount];
+	for (int32 i = 0; i < s_treeProxyCount; ++i)
+	{
+		aabbs[i] = RandomAABB(s_treeExtent, 2.0f);
+	}
+
+	KernelTimer timer(result, "b2DynamicTree::CreateProxy", s_treeProxyCount);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		b2DynamicTree tree;
+		timer.Begin();
+		for (int32 i = 0; i < s_treeProxyCount; ++i)
+		{
+			tree.CreateProxy(aabbs[i], NULL);
+		}
+		timer.End();
+		s_sink += float32(tree.GetHeight());
+	}
+
+	delete [] aabbs;
+}
+
+static void TreeMoveProxy(KernelResult* result)
+{
+	b2AABB* aabbs = new b2AABB[s_treeProxyCount];
+	b2Vec2* displacements = new b2Vec2[s_treeProxyCount];
+	int32* proxyIds = new int32[s_treeProxyCount];
+
+	b2DynamicTree tree;
+	for (int32 i = 0; i < s_treeProxyCount; ++i)
+	{
+		aabbs[i] = RandomAABB(s_treeExtent, 2.0f);
+		proxyIds[i] = tree.CreateProxy(aabbs[i], NULL);
+		displacements[i].Set(RandomFloat(-0.5f, 0.5f), RandomFloat(-0.5f, 0.5f));
+	}
+
+	// Every move leaves the fat AABB so each one re-inserts the proxy. The
+	// proxies drift back and forth to keep the tree statistics stable.
+	KernelTimer timer(result, "b2DynamicTree::MoveProxy", s_treeProxyCount);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		float32 sign = (rep & 1) ? -1.0f : 1.0f;
+		timer.Begin();
+		for (int32 i = 0; i < s_treeProxyCount; ++i)
+		{
+			b2Vec2 d = sign * (displacements[i] + b2Vec2(b2_aabbExtension, b2_aabbExtension));
+			aabbs[i].lowerBound += d;
+			aabbs[i].upperBound += d;
+			tree.MoveProxy(proxyIds[i], aabbs[i], d);
+		}
+		timer.End();
+		s_sink += float32(tree.GetHeight());
+	}
+
+	delete [] proxyIds;
+	delete [] displacements;
+	delete [] aabbs;
+}
+
+static void TreeQuery(KernelResult* result)
+{
+	const int32 count = 8192;
+	b2DynamicTree tree;
+	for (int32 i = 0; i < s_treeProxyCount; ++i)
+	{
+		tree.CreateProxy(RandomAABB(s_treeExtent, 2.0f), NULL);
+	}
+
+	b2AABB* queries = new b2AABB[count];
+	for (int32 i = 0; i < count; ++i)
+	{
+		queries[i] = RandomAABB(s_treeExtent, 4.0f);
+	}
+
+	KernelTimer timer(result, "b2DynamicTree::Query", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		TreeQueryCallback callback;
+		callback.m_sum = 0;
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			tree.Query(&callback, queries[i]);
+		}
+		timer.End();
+		s_sink += float32(callback.m_sum);
+	}
+
+	delete [] queries;
+}
+
+static void TreeRayCast(KernelResult* result)
+{
+	const int32 count = 2048;
+	b2DynamicTree tree;
+	for (int32 i = 0; i < s_treeProxyCount; ++i)
+	{
+		tree.CreateProxy(RandomAABB(s_treeExtent, 2.0f), NULL);
+	}
+
+	b2RayCastInput* rays = new b2RayCastInput[count];
+	for (int32 i = 0; i < count; ++i)
+	{
+		rays[i].p1.Set(RandomFloat(-s_treeExtent, s_treeExtent), RandomFloat(-s_treeExtent, s_treeExtent));
+		rays[i].p2 = rays[i].p1 + b2Vec2(RandomFloat(-20.0f, 20.0f), RandomFloat(-20.0f, 20.0f));
+		rays[i].maxFraction = 1.0f;
+	}
+
+	KernelTimer timer(result, "b2DynamicTree::RayCast", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		TreeQueryCallback callback;
+		callback.m_sum = 0;
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			tree.RayCast(&callback, rays[i]);
+		}
+		timer.End();
+		s_sink += float32(callback.m_sum);
+	}
+
+	delete [] rays;
+}
+
+static void BlockAllocator(KernelResult* result)
+{
+	// Live blocks of mixed sizes freed in random order, the pattern of
+	// contacts and fixtures coming and going.
+	const int32 count = 8192;
+	int32* sizes = new int32[count];
+	int32* order = new int32[count];
+	void** blocks = new void*[count];
+	for (int32 i = 0; i < count; ++i)
+	{
+		sizes[i] = 16 + RandomInt(b2_maxBlockSize - 16);
+		order[i] = i;
+	}
+
+	for (int32 i = count - 1; i > 0; --i)
+	{
+		b2Swap(order[i], order[RandomInt(i + 1)]);
+	}
+
+	b2BlockAllocator allocator;
+	KernelTimer timer(result, "b2BlockAllocator", count);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			blocks[i] = allocator.Allocate(sizes[i]);
+		}
+		for (int32 i = 0; i < count; ++i)
+		{
+			int32 index = order[i];
+			allocator.Free(blocks[index], sizes[index]);
+		}
+		timer.End();
+	}
+
+	delete [] blocks;
+	delete [] order;
+	delete [] sizes;
+}
+
+static void StackAllocator(KernelResult* result)
+{
+	// Nested allocations as made by the island solver and TOI.
+	const int32 count = 65536;
+	const int32 depth = 8;
+	int32 sizes[depth];
+	for (int32 i = 0; i < depth; ++i)
+	{
+		sizes[i] = 64 + RandomInt(b2_stackSize / (2 * depth));
+	}
+
+	b2StackAllocator allocator;
+	void* blocks[depth];
+	KernelTimer timer(result, "b2StackAllocator", count * depth);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		timer.Begin();
+		for (int32 i = 0; i < count; ++i)
+		{
+			for (int32 j = 0; j < depth; ++j)
+			{
+				blocks[j] = allocator.Allocate(sizes[j]);
+			}
+			for (int32 j = depth - 1; j >= 0; --j)
+			{
+				allocator.Free(blocks[j]);
+			}
+		}
+		timer.End();
+	}
+}
+
+// A settled pile of boxes and circles provides the constraint set. The
+// bodies are put in an island to index them and the solver is run on its
+// own, restoring the state before each repetition.
+static void ContactSolver(KernelResult* results)
+{
+	b2World world(b2Vec2(0.0f, -10.0f));
+
+	b2BodyDef bd;
+	b2Body* ground = world.CreateBody(&bd);
+	b2EdgeShape edge;
+	edge.Set(b2Vec2(-30.0f, 0.0f), b2Vec2(30.0f, 0.0f));
+	ground->CreateFixture(&edge, 0.0f);
+	edge.Set(b2Vec2(-30.0f, 0.0f), b2Vec2(-30.0f, 60.0f));
+	ground->CreateFixture(&edge, 0.0f);
+	edge.Set(b2Vec2(30.0f, 0.0f), b2Vec2(30.0f, 60.0f));
+	ground->CreateFixture(&edge, 0.0f);
+
+	bd.type = b2_dynamicBody;
+	b2PolygonShape box;
+	box.SetAsBox(0.5f, 0.5f);
+	b2CircleShape circle;
+	circle.m_radius = 0.5f;
+	for (int32 i = 0; i < 1200; ++i)
+	{
+		bd.position.Set(RandomFloat(-29.0f, 29.0f), RandomFloat(1.0f, 50.0f));
+		bd.angle = RandomFloat(-b2_pi, b2_pi);
+		b2Body* body = world.CreateBody(&bd);
+		body->CreateFixture(RandomInt(4) == 0 ? (b2Shape*)&circle : (b2Shape*)&box, 1.0f);
+	}
+
+	for (int32 i = 0; i < 180; ++i)
+	{
+		world.Step(1.0f / 60.0f, 8, 3);
+	}
+
+	int32 contactCount = 0;
+	b2Contact** contacts = new b2Contact*[world.GetContactCount()];
+	for (b2Contact* c = world.GetContactList(); c; c = c->GetNext())
+	{
+		if (c->IsTouching() && c->IsEnabled())
+		{
+			contacts[contactCount++] = c;
+		}
+	}
+
+	b2StackAllocator allocator;
+	b2Island island(world.GetBodyCount(), 0, 0, &allocator, NULL);
+	for (b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		island.Add(b);
+	}
+
+	int32 bodyCount = island.m_bodyCount;
+	b2Position* positions = new b2Position[bodyCount];
+	b2Velocity* velocities = new b2Velocity[bodyCount];
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = island.m_bodies[i];
+		positions[i].c = b->GetWorldCenter();
+		positions[i].a = b->GetAngle();
+		velocities[i].v = b->GetLinearVelocity();
+		velocities[i].w = b->GetAngularVelocity();
+	}
+
+	const int32 velocityIterations = 8;
+	const int32 positionIterations = 3;
+
+	b2ContactSolverDef def;
+	def.step.dt = 1.0f / 60.0f;
+	def.step.inv_dt = 60.0f;
+	def.step.dtRatio = 1.0f;
+	def.step.velocityIterations = velocityIterations;
+	def.step.positionIterations = positionIterations;
+	def.step.warmStarting = true;
+	def.contacts = contacts;
+	def.count = contactCount;
+	def.positions = island.m_positions;
+	def.velocities = island.m_velocities;
+	def.allocator = &allocator;
+
+	KernelTimer velocityTimer(results + 0, "b2ContactSolver::SolveVelocityConstraints", contactCount * velocityIterations);
+	KernelTimer positionTimer(results + 1, "b2ContactSolver::SolvePositionConstraints", contactCount * positionIterations);
+	for (int32 rep = 0; rep < s_reps; ++rep)
+	{
+		memcpy(island.m_positions, positions, bodyCount * sizeof(b2Position));
+		memcpy(island.m_velocities, velocities, bodyCount * sizeof(b2Velocity));
+
+		b2ContactSolver solver(&def);
+		solver.InitializeVelocityConstraints();
+		solver.WarmStart();
+
+		velocityTimer.Begin();
+		for (int32 i = 0; i < velocityIterations; ++i)
+		{
+			solver.SolveVelocityConstraints();
+		}
+		velocityTimer.End();
+
+		// Run every iteration, the island solver would exit early.
+		positionTimer.Begin();
+		for (int32 i = 0; i < positionIterations; ++i)
+		{
+			solver.SolvePositionConstraints();
+		}
+		positionTimer.End();
+
+		s_sink += island.m_velocities[bodyCount / 2].w + island.m_positions[bodyCount / 2].a;
+	}
+
+	delete [] velocities;
+	delete [] positions;
+	delete [] contacts;
+}
+
+static void WriteJson(const char* path, uint32 seed, const KernelResult* results, int32 count)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		fprintf(stderr, "cannot write %s\n", path);
+		return;
+	}
+
+	fprintf(file, "{\n  \"benchmark\": \"kernels\",\n  \"seed\": %u,\n  \"reps\": %d,\n  \"results\": [\n", seed, s_reps);
+	for (int32 i = 0; i < count; ++i)
+	{
+		const KernelResult* r = results + i;
+		fprintf(file, "    {\"name\": \"%s\", \"ops\": %d, \"nsPerOp\": %.3f, \"meanNsPerOp\": %.3f",
+			r->name, r->ops, r->bestNs, r->meanNs);
+		if (s_perfCounters.IsOpen())
+		{
+			float64 perOp = 1.0 / (float64(r->ops) * s_reps);
+			fprintf(file, ", \"cyclesPerOp\": %.2f, \"ipc\": %.3f, \"l1dMissesPerOp\": %.4f, \"llcMissesPerOp\": %.4f, \"branchMissesPerOp\": %.4f",
+				r->counters.cycles * perOp,
+				r->counters.cycles > 0 ? float64(r->counters.instructions) / r->counters.cycles : 0.0,
+				r->counters.l1dMisses * perOp, r->counters.llcMisses * perOp, r->counters.branchMisses * perOp);
+		}
+		fprintf(file, "}%s\n", i + 1 < count ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+	fclose(file);
+}
+
+int main(int argc, char** argv)
+{
+	uint32 seed = 1;
+	const char* filter = NULL;
+	const char* jsonPath = NULL;
+	for (int32 i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+		{
+			seed = uint32(strtoul(argv[++i], NULL, 10));
+		}
+		else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc)
+		{
+			s_reps = b2Max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else
+		{
+			fprintf(stderr, "usage: %s [--seed n] [--reps n] [--filter substring] [--json file]\n", argv[0]);
+			return 1;
+		}
+	}
+
+#if defined(B2_USE_SSE)
+	if (filter == NULL || strstr("b2CollidePolygons", filter) != NULL)
+	{
+		s_seed = seed;
+		if (CheckCollidePolygons() != 0)
+		{
+			return 2;
+		}
+	}
+#endif
+
+	s_perfCounters.Open();
+
+	struct Kernel
+	{
+		const char* name;
+		void (*run)(KernelResult* results);
+		int32 resultCount;
+	};
+
+	const Kernel kernels[] =
+	{
+		{ "b2CollidePolygons", CollidePolygons, 1 },
+		{ "b2CollideCircles", CollideCircles, 1 },
+		{ "b2CollideEdgeAndPolygon", CollideEdgeAndPolygon, 1 },
+		{ "b2Distance", Distance, 1 },
+		{ "b2TimeOfImpact", TimeOfImpact, 1 },
+		{ "b2DynamicTree::CreateProxy", TreeCreateProxy, 1 },
+		{ "b2DynamicTree::MoveProxy", TreeMoveProxy, 1 },
+		{ "b2DynamicTree::Query", TreeQuery, 1 },
+		{ "b2DynamicTree::RayCast", TreeRayCast, 1 },
+		{ "b2BlockAllocator", BlockAllocator, 1 },
+		{ "b2StackAllocator", StackAllocator, 1 },
+		{ "b2ContactSolver", ContactSolver, 2 }
+	};
+	const int32 kernelCount = sizeof(kernels) / sizeof(kernels[0]);
+
+	KernelResult results[kernelCount + 1];
+	int32 resultCount = 0;
+	for (int32 i = 0; i < kernelCount; ++i)
+	{
+		if (filter && strstr(kernels[i].name, filter) == NULL)
+		{
+			continue;
+		}
+
+		// Each kernel draws from its own seed so filtering does not change the inputs.
+		s_seed = seed + 7919 * uint32(i);
+		kernels[i].run(results + resultCount);
+		resultCount += kernels[i].resultCount;
+	}
+
+	printf("%-44s %10s %12s %12s\n", "kernel", "ops", "best ns/op", "mean ns/op");
+	for (int32 i = 0; i < resultCount; ++i)
+	{
+		printf("%-44s %10d %12.2f %12.2f\n", results[i].name, results[i].ops, results[i].bestNs, results[i].meanNs);
+	}
+
+	if (s_perfCounters.IsOpen() == false)
+	{
+		printf("hardware counters unavailable\n");
+	}
+
+	if (jsonPath)
+	{
+		WriteJson(jsonPath, seed, results, resultCount);
+	}
+
+	return 0;
+}
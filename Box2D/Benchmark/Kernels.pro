@@ -0,0 +1,23 @@
+# Kernel microbenchmarks. Build Box2D.pro first, this links lib/libBox2D.a.
+QT -= core \
+      gui
+
+TEMPLATE = app
+TARGET = Kernels
+
+CONFIG += console release warn_on
+CONFIG -= app_bundle
+
+DESTDIR = ../bin
+OBJECTS_DIR = tmp
+
+INCLUDEPATH += ../..
+QMAKE_LIBDIR += ../lib
+LIBS += -lBox2D
+PRE_TARGETDEPS += ../lib/libBox2D.a
+
+# The scalar b2CollidePolygons that Kernels checks the SSE one against.
+# Contraction into FMA would change its rounding.
+SOURCES += Kernels.cpp \
+           CollidePolygonsScalar.cpp
+gcc|clang: QMAKE_CXXFLAGS += -ffp-contract=off
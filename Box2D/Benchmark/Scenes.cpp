@@ -0,0 +1,1102 @@
+// Whole-step benchmark on standard stress scenes and the game levels. Each
+// scene is built, stepped for a fixed number of frames at 60 Hz and reported
+// with step time percentiles, the b2Profile phase breakdown and peak memory.
+// Scene construction is seeded, so runs are comparable. With --baseline the
+// results are compared against a JSON file written by an earlier --json run.
+//
+// Usage: Scenes [--frames n] [--scene substring] [--levels dir] [--json file]
+//               [--baseline file] [--threshold percent]
+
+#include <Box2D/Box2D.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <dirent.h>
+#endif
+
+#if !defined(BOX2D_LEVELS_DIR)
+#define BOX2D_LEVELS_DIR "data/levels"
+#endif
+
+static uint32 s_seed = 1;
+
+static float32 RandomFloat(float32 lo, float32 hi)
+{
+	s_seed = 1664525 * s_seed + 1013904223;
+	float32 r = float32(s_seed >> 8) / float32(1 << 24);
+	return lo + (hi - lo) * r;
+}
+
+struct Scene
+{
+	char name[64];
+	char path[256];		// level file, empty for the built-in scenes
+	void (*create)(b2World* world, const Scene* scene);
+	void (*update)(b2World* world, int32 frame);
+};
+
+// Static box container open at the top.
+static b2Body* CreateContainer(b2World* world, float32 halfWidth, float32 height)
+{
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+	b2EdgeShape edge;
+	edge.Set(b2Vec2(-halfWidth, 0.0f), b2Vec2(halfWidth, 0.0f));
+	ground->CreateFixture(&edge, 0.0f);
+	edge.Set(b2Vec2(-halfWidth, 0.0f), b2Vec2(-halfWidth, height));
+	ground->CreateFixture(&edge, 0.0f);
+	edge.Set(b2Vec2(halfWidth, 0.0f), b2Vec2(halfWidth, height));
+	ground->CreateFixture(&edge, 0.0f);
+	return ground;
+}
+
+// 100 rows, 5050 boxes.
+static void CreatePyramid(b2World* world, const Scene*)
+{
+	CreateContainer(world, 80.0f, 10.0f);
+
+	const int32 rows = 100;
+	b2PolygonShape box;
+	box.SetAsBox(0.5f, 0.5f);
+
+	b2BodyDef bd;
+	bd.type = b2_dynamicBody;
+	for (int32 i = 0; i < rows; ++i)
+	{
+		float32 y = 0.5f + 1.0f * i;
+		float32 x0 = -0.5625f * (rows - 1 - i);
+		for (int32 j = i; j < rows; ++j)
+		{
+			bd.position.Set(x0 + 1.125f * (j - i), y);
+			world->CreateBody(&bd)->CreateFixture(&box, 5.0f);
+		}
+	}
+}
+
+// 20000 circles in a rotating box driven by a motor.
+static void CreateTumbler(b2World* world, const Scene*)
+{
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+
+	const float32 halfSize = 20.0f;
+	bd.type = b2_dynamicBody;
+	bd.allowSleep = false;
+	bd.position.Set(0.0f, 25.0f);
+	b2Body* box = world->CreateBody(&bd);
+
+	b2PolygonShape wall;
+	wall.SetAsBox(0.5f, halfSize, b2Vec2(halfSize, 0.0f), 0.0f);
+	box->CreateFixture(&wall, 5.0f);
+	wall.SetAsBox(0.5f, halfSize, b2Vec2(-halfSize, 0.0f), 0.0f);
+	box->CreateFixture(&wall, 5.0f);
+	wall.SetAsBox(halfSize, 0.5f, b2Vec2(0.0f, halfSize), 0.0f);
+	box->CreateFixture(&wall, 5.0f);
+	wall.SetAsBox(halfSize, 0.5f, b2Vec2(0.0f, -halfSize), 0.0f);
+	box->CreateFixture(&wall, 5.0f);
+
+	b2RevoluteJointDef jd;
+	jd.bodyA = ground;
+	jd.bodyB = box;
+	jd.localAnchorA.Set(0.0f, 25.0f);
+	jd.localAnchorB.Set(0.0f, 0.0f);
+	jd.referenceAngle = 0.0f;
+	jd.motorSpeed = 0.05f * b2_pi;
+	jd.maxMotorTorque = 1e8f;
+	jd.enableMotor = true;
+	world->CreateJoint(&jd);
+
+	b2CircleShape circle;
+	circle.m_radius = 0.125f;
+
+	b2BodyDef cd;
+	cd.type = b2_dynamicBody;
+	const int32 columns = 145;
+	const int32 count = 20000;
+	const float32 spacing = 0.265f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 x = -0.5f * spacing * (columns - 1) + spacing * (i % columns);
+		float32 y = 25.0f - halfSize + 1.0f + spacing * (i / columns);
+		cd.position.Set(x + RandomFloat(-0.01f, 0.01f), y);
+		world->CreateBody(&cd)->CreateFixture(&circle, 1.0f);
+	}
+}
+
+// Ten bodies and nine limited revolute joints.
+static void CreateRagdoll(b2World* world, const b2Vec2& origin)
+{
+	b2BodyDef bd;
+	bd.type = b2_dynamicBody;
+
+	b2FixtureDef fd;
+	fd.density = 1.0f;
+	fd.friction = 0.4f;
+
+	b2CircleShape headShape;
+	headShape.m_radius = 0.25f;
+	b2PolygonShape torsoShape;
+	torsoShape.SetAsBox(0.22f, 0.4f);
+	b2PolygonShape armShape;
+	armShape.SetAsBox(0.28f, 0.07f);
+	b2PolygonShape legShape;
+	legShape.SetAsBox(0.09f, 0.3f);
+
+	bd.position = origin + b2Vec2(0.0f, 1.95f);
+	fd.shape = &headShape;
+	b2Body* head = world->CreateBody(&bd);
+	head->CreateFixture(&fd);
+
+	bd.position = origin + b2Vec2(0.0f, 1.3f);
+	fd.shape = &torsoShape;
+	b2Body* torso = world->CreateBody(&bd);
+	torso->CreateFixture(&fd);
+
+	b2RevoluteJointDef jd;
+	jd.enableLimit = true;
+	jd.lowerAngle = -0.25f * b2_pi;
+	jd.upperAngle = 0.25f * b2_pi;
+	jd.Initialize(torso, head, origin + b2Vec2(0.0f, 1.7f));
+	world->CreateJoint(&jd);
+
+	for (int32 side = -1; side <= 1; side += 2)
+	{
+		fd.shape = &armShape;
+		bd.position = origin + b2Vec2(side * 0.5f, 1.6f);
+		b2Body* upperArm = world->CreateBody(&bd);
+		upperArm->CreateFixture(&fd);
+		bd.position = origin + b2Vec2(side * 1.06f, 1.6f);
+		b2Body* lowerArm = world->CreateBody(&bd);
+		lowerArm->CreateFixture(&fd);
+
+		jd.lowerAngle = -0.5f * b2_pi;
+		jd.upperAngle = 0.5f * b2_pi;
+		jd.Initialize(torso, upperArm, origin + b2Vec2(side * 0.22f, 1.6f));
+		world->CreateJoint(&jd);
+		jd.lowerAngle = side < 0 ? 0.0f : -0.75f * b2_pi;
+		jd.upperAngle = side < 0 ? 0.75f * b2_pi : 0.0f;
+		jd.Initialize(upperArm, lowerArm, origin + b2Vec2(side * 0.78f, 1.6f));
+		world->CreateJoint(&jd);
+
+		fd.shape = &legShape;
+		bd.position = origin + b2Vec2(side * 0.12f, 0.62f);
+		b2Body* upperLeg = world->CreateBody(&bd);
+		upperLeg->CreateFixture(&fd);
+		bd.position = origin + b2Vec2(side * 0.12f, 0.02f);
+		b2Body* lowerLeg = world->CreateBody(&bd);
+		lowerLeg->CreateFixture(&fd);
+
+		jd.lowerAngle = -0.25f * b2_pi;
+		jd.upperAngle = 0.5f * b2_pi;
+		jd.Initialize(torso, upperLeg, origin + b2Vec2(side * 0.12f, 0.92f));
+		world->CreateJoint(&jd);
+		jd.lowerAngle = -0.75f * b2_pi;
+		jd.upperAngle = 0.0f;
+		jd.Initialize(upperLeg, lowerLeg, origin + b2Vec2(side * 0.12f, 0.32f));
+		world->CreateJoint(&jd);
+	}
+}
+
+// 300 ragdolls dropped into a pit.
+static void CreateRagdolls(b2World* world, const Scene*)
+{
+	CreateContainer(world, 25.0f, 80.0f);
+	const int32 columns = 15;
+	for (int32 i = 0; i < 300; ++i)
+	{
+		b2Vec2 origin(-22.5f + 3.2f * (i % columns) + RandomFloat(-0.3f, 0.3f), 1.0f + 2.8f * (i / columns));
+		CreateRagdoll(world, origin);
+	}
+}
+
+// A wall of 800 boxes under fire from a stream of small fast bullets.
+static void CreateBullets(b2World* world, const Scene*)
+{
+	b2BodyDef bd;
+	b2Body* ground = world->CreateBody(&bd);
+	b2EdgeShape edge;
+	edge.Set(b2Vec2(-40.0f, 0.0f), b2Vec2(80.0f, 0.0f));
+	ground->CreateFixture(&edge, 0.0f);
+	edge.Set(b2Vec2(80.0f, 0.0f), b2Vec2(80.0f, 40.0f));
+	ground->CreateFixture(&edge, 0.0f);
+
+	b2PolygonShape box;
+	box.SetAsBox(0.25f, 0.25f);
+	bd.type = b2_dynamicBody;
+	for (int32 i = 0; i < 32; ++i)
+	{
+		for (int32 j = 0; j < 25; ++j)
+		{
+			bd.position.Set(20.0f + 0.52f * i, 0.25f + 0.5f * j);
+			world->CreateBody(&bd)->CreateFixture(&box, 1.0f);
+		}
+	}
+}
+
+static void UpdateBullets(b2World* world, int32 frame)
+{
+	// One bullet every other frame for the first 400 frames.
+	if (frame % 2 != 0 || frame >= 800)
+	{
+		return;
+	}
+
+	b2CircleShape circle;
+	circle.m_radius = 0.1f;
+
+	b2BodyDef bd;
+	bd.type = b2_dynamicBody;
+	bd.bullet = true;
+	bd.position.Set(-30.0f, RandomFloat(0.5f, 12.0f));
+	bd.linearVelocity.Set(200.0f, RandomFloat(-5.0f, 5.0f));
+	world->CreateBody(&bd)->CreateFixture(&circle, 20.0f);
+}
+
+// A 10000 vertex chain over rolling noise with 2000 mixed bodies dropped on it.
+static void CreateTerrain(b2World* world, const Scene*)
+{
+	const int32 vertexCount = 10000;
+	const float32 dx = 0.5f;
+	const float32 x0 = -0.5f * dx * vertexCount;
+	b2Vec2* vertices = new b2Vec2[vertexCount];
+	for (int32 i = 0; i < vertexCount; ++i)
+	{
+		float32 x = x0 + dx * i;
+		vertices[i].Set(x, 3.0f * sinf(0.05f * x) + 0.8f * sinf(0.31f * x) + RandomFloat(-0.2f, 0.2f));
+	}
+
+	b2ChainShape chain;
+	chain.CreateChain(vertices, vertexCount);
+	b2BodyDef bd;
+	world->CreateBody(&bd)->CreateFixture(&chain, 0.0f);
+	delete [] vertices;
+
+	b2PolygonShape box;
+	box.SetAsBox(0.4f, 0.4f);
+	b2CircleShape circle;
+	circle.m_radius = 0.4f;
+	b2PolygonShape hexagon;
+	b2Vec2 hull[6];
+	for (int32 i = 0; i < 6; ++i)
+	{
+		float32 angle = 2.0f * b2_pi * i / 6.0f;
+		hull[i].Set(0.45f * cosf(angle), 0.45f * sinf(angle));
+	}
+	hexagon.Set(hull, 6);
+	const b2Shape* shapes[3] = { &box, &circle, &hexagon };
+
+	bd.type = b2_dynamicBody;
+	for (int32 i = 0; i < 2000; ++i)
+	{
+		bd.position.Set(RandomFloat(0.45f * x0, -0.45f * x0), RandomFloat(6.0f, 20.0f));
+		bd.angle = RandomFloat(-b2_pi, b2_pi);
+		world->CreateBody(&bd)->CreateFixture(shapes[i % 3], 1.0f);
+	}
+}
+
+// Reads the level format of QBox2DWorld::loadWorld: objects with position,
+// physic and geometry children, and revolute joints between named objects.
+// Only the attributes and the nesting matter here so a tag scanner is enough.
+class LevelReader
+{
+public:
+	LevelReader(const char* text)
+	{
+		m_text = text;
+		m_tagEnd = NULL;
+	}
+
+	// Advance to the next tag. Returns false at the end of the text.
+	bool NextTag(char* name, int32 capacity, bool* closing)
+	{
+		for (;;)
+		{
+			const char* open = strchr(m_text, '<');
+			if (open == NULL)
+			{
+				return false;
+			}
+
+			const char* close = strchr(open, '>');
+			if (close == NULL)
+			{
+				return false;
+			}
+
+			m_text = close + 1;
+			if (open[1] == '?' || open[1] == '!')
+			{
+				continue;
+			}
+
+			*closing = open[1] == '/';
+			const char* s = open + (*closing ? 2 : 1);
+			int32 length = 0;
+			while (s[length] && strchr(" \t\r\n/>", s[length]) == NULL && length < capacity - 1)
+			{
+				name[length] = s[length];
+				++length;
+			}
+			name[length] = 0;
+			m_tagStart = s + length;
+			m_tagEnd = close;
+			return true;
+		}
+	}
+
+	// Copy an attribute of the current tag. Returns false if it is missing.
+	bool Attribute(const char* key, char* value, int32 capacity) const
+	{
+		int32 keyLength = int32(strlen(key));
+		for (const char* s = m_tagStart; s && s < m_tagEnd; ++s)
+		{
+			if (strncmp(s, key, keyLength) != 0 || s[keyLength] != '=' || strchr(" \t\r\n", s[-1]) == NULL)
+			{
+				continue;
+			}
+
+			char quote = s[keyLength + 1];
+			const char* begin = s + keyLength + 2;
+			const char* end = strchr(begin, quote);
+			if (end == NULL || end > m_tagEnd)
+			{
+				return false;
+			}
+
+			int32 length = b2Min(int32(end - begin), capacity - 1);
+			memcpy(value, begin, length);
+			value[length] = 0;
+			return true;
+		}
+		return false;
+	}
+
+	float32 FloatAttribute(const char* key, float32 defaultValue) const
+	{
+		char value[64];
+		return Attribute(key, value, sizeof(value)) ? float32(atof(value)) : defaultValue;
+	}
+
+	// Is the current tag an empty element, as in <position x="0" y="0"/>?
+	bool IsEmpty() const
+	{
+		return m_tagEnd && m_tagEnd[-1] == '/';
+	}
+
+private:
+	const char* m_text;
+	const char* m_tagStart;
+	const char* m_tagEnd;
+};
+
+struct LevelObject
+{
+	char name[64];
+	b2Body* body;
+};
+
+// A joint as read from the file. Its bodies are looked up by name once the
+// whole file has been read, as QBox2DWorld::parseXMLStream does.
+struct LevelJoint
+{
+	bool revolute;
+	bool hasBodies;
+	char bodyA[64];
+	char bodyB[64];
+	bool hasMotor;
+	float32 motorSpeed;
+	float32 maxMotorTorque;
+	bool enableMotor;
+};
+
+static char* ReadFile(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	if (file == NULL)
+	{
+		return NULL;
+	}
+
+	fseek(file, 0, SEEK_END);
+	long size = ftell(file);
+	fseek(file, 0, SEEK_SET);
+	char* text = (char*)malloc(size + 1);
+	size_t read = fread(text, 1, size, file);
+	text[read] = 0;
+	fclose(file);
+	return text;
+}
+
+// The body of the newest object with this name, a later object replaces an
+// earlier one of the same name. Objects without a name are never found.
+static b2Body* FindLevelObject(const std::vector<LevelObject>& objects, const char* name)
+{
+	for (size_t i = objects.size(); i > 0; --i)
+	{
+		if (objects[i - 1].name[0] && strcmp(objects[i - 1].name, name) == 0)
+		{
+			return objects[i - 1].body;
+		}
+	}
+	return NULL;
+}
+
+// Builds a level with the rules of the game's loaders: only the first gravity,
+// objects and joints element of the world counts, the first of each child of
+// an object or joint wins, and joints are resolved after the whole file.
+static void CreateLevel(b2World* world, const Scene* scene)
+{
+	char* text = ReadFile(scene->path);
+	if (text == NULL)
+	{
+		fprintf(stderr, "cannot read %s\n", scene->path);
+		return;
+	}
+
+	// The game's base world starts without gravity and has a ground body
+	// for joints to reference as _ground.
+	world->SetGravity(b2Vec2(0.0f, 0.0f));
+	b2BodyDef groundDef;
+	b2Body* ground = world->CreateBody(&groundDef);
+
+	std::vector<LevelObject> objects;
+	std::vector<LevelJoint> joints;
+	LevelReader reader(text);
+	char tag[64], value[64];
+	bool closing;
+
+	// Nesting depth of the open elements: the world is 1, its sections 2,
+	// objects and joints 3 and their children 4.
+	enum Section
+	{
+		e_otherSection,
+		e_objectsSection,
+		e_jointsSection
+	};
+	enum Child
+	{
+		e_position = 1,
+		e_physic = 2,
+		e_geometry = 4,
+		e_bodies = 8,
+		e_motor = 16
+	};
+	int32 depth = 0;
+	Section section = e_otherSection;
+	bool gravitySeen = false, objectsSeen = false, jointsSeen = false;
+	bool inObject = false, inJoint = false;
+	int32 seen = 0;
+
+	b2BodyDef bd;
+	b2FixtureDef fd;
+	char geometry[16] = "";
+	float32 width = 0.0f, height = 0.0f, radius = 0.0f;
+	LevelObject object;
+	LevelJoint joint;
+
+	while (reader.NextTag(tag, sizeof(tag), &closing))
+	{
+		int32 level = closing ? depth : depth + 1;
+		if (closing == false && reader.IsEmpty() == false)
+		{
+			++depth;
+		}
+		else if (closing)
+		{
+			--depth;
+		}
+
+		if (level == 1 && closing == false && strcmp(tag, "world") != 0)
+		{
+			fprintf(stderr, "%s is not a world file\n", scene->path);
+			break;
+		}
+
+		if (level == 2 && closing == false)
+		{
+			section = e_otherSection;
+			if (strcmp(tag, "gravity") == 0 && gravitySeen == false)
+			{
+				gravitySeen = true;
+				if (reader.Attribute("strength", value, sizeof(value)))
+				{
+					world->SetGravity(b2Vec2(reader.FloatAttribute("direction", 0.0f), float32(atof(value))));
+				}
+			}
+			else if (strcmp(tag, "objects") == 0 && objectsSeen == false)
+			{
+				objectsSeen = true;
+				section = e_objectsSection;
+			}
+			else if (strcmp(tag, "joints") == 0 && jointsSeen == false)
+			{
+				jointsSeen = true;
+				section = e_jointsSection;
+			}
+		}
+		else if (level == 2)
+		{
+			section = e_otherSection;
+		}
+		else if (level == 3 && closing == false && section == e_objectsSection && strcmp(tag, "object") == 0)
+		{
+			inObject = true;
+			seen = 0;
+			bd = b2BodyDef();
+			fd = b2FixtureDef();
+			geometry[0] = 0;
+			width = height = radius = 0.0f;
+			object.name[0] = 0;
+			if (reader.Attribute("bodyType", value, sizeof(value)) && strcmp(value, "dynamic") == 0)
+			{
+				bd.type = b2_dynamicBody;
+			}
+			reader.Attribute("name", object.name, sizeof(object.name));
+		}
+		else if (level == 3 && closing == false && section == e_jointsSection && strcmp(tag, "joint") == 0)
+		{
+			inJoint = true;
+			seen = 0;
+			memset(&joint, 0, sizeof(joint));
+			joint.revolute = reader.Attribute("type", value, sizeof(value)) && strcmp(value, "revolute") == 0;
+		}
+		else if (level == 4 && closing == false && inObject)
+		{
+			if (strcmp(tag, "position") == 0 && (seen & e_position) == 0)
+			{
+				seen |= e_position;
+				bd.position.Set(reader.FloatAttribute("x", 0.0f), reader.FloatAttribute("y", 0.0f));
+				bd.angle = reader.FloatAttribute("rotation", 0.0f) * b2_pi / 180.0f;
+			}
+			else if (strcmp(tag, "physic") == 0 && (seen & e_physic) == 0)
+			{
+				seen |= e_physic;
+				fd.density = reader.FloatAttribute("density", 0.0f);
+				fd.friction = reader.FloatAttribute("friction", 0.0f);
+				fd.restitution = reader.FloatAttribute("restitution", 0.0f);
+			}
+			else if (strcmp(tag, "geometry") == 0 && (seen & e_geometry) == 0)
+			{
+				seen |= e_geometry;
+				reader.Attribute("type", geometry, sizeof(geometry));
+				width = reader.FloatAttribute("width", 0.0f);
+				height = reader.FloatAttribute("height", 0.0f);
+				radius = reader.FloatAttribute("radius", 0.0f);
+			}
+		}
+		else if (level == 4 && closing == false && inJoint)
+		{
+			if (strcmp(tag, "bodies") == 0 && (seen & e_bodies) == 0)
+			{
+				seen |= e_bodies;
+				joint.hasBodies = true;
+				reader.Attribute("a", joint.bodyA, sizeof(joint.bodyA));
+				reader.Attribute("b", joint.bodyB, sizeof(joint.bodyB));
+			}
+			else if (strcmp(tag, "motor") == 0 && (seen & e_motor) == 0)
+			{
+				seen |= e_motor;
+				joint.hasMotor = true;
+				joint.motorSpeed = reader.FloatAttribute("speed", 0.0f);
+				joint.maxMotorTorque = reader.FloatAttribute("torque", 0.0f);
+				joint.enableMotor = reader.Attribute("enable", value, sizeof(value)) && strcmp(value, "true") == 0;
+			}
+		}
+
+		// An object or joint ends at its closing tag, or at once when it is empty.
+		bool ends = level == 3 && (closing || reader.IsEmpty());
+		if (ends && inObject)
+		{
+			inObject = false;
+			object.body = world->CreateBody(&bd);
+			b2PolygonShape box;
+			b2CircleShape circle;
+			if (strcmp(geometry, "box") == 0)
+			{
+				box.SetAsBox(0.5f * width, 0.5f * height);
+				fd.shape = &box;
+				object.body->CreateFixture(&fd);
+			}
+			else if (strcmp(geometry, "circle") == 0)
+			{
+				circle.m_radius = radius;
+				fd.shape = &circle;
+				object.body->CreateFixture(&fd);
+			}
+			objects.push_back(object);
+		}
+		else if (ends && inJoint)
+		{
+			inJoint = false;
+			joints.push_back(joint);
+		}
+	}
+
+	free(text);
+
+	// The game stops at a file without objects, before its joints.
+	if (objectsSeen == false)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < joints.size(); ++i)
+	{
+		const LevelJoint& j = joints[i];
+		if (j.revolute == false)
+		{
+			continue;
+		}
+
+		b2Body* a = j.hasBodies ? FindLevelObject(objects, j.bodyA) : NULL;
+		b2Body* b = j.hasBodies == false ? NULL :
+			strcmp(j.bodyB, "_ground") == 0 ? ground : FindLevelObject(objects, j.bodyB);
+		if (a == NULL || b == NULL)
+		{
+			fprintf(stderr, "%s: joint between '%s' and '%s' ignored\n", scene->path, j.bodyA, j.bodyB);
+			continue;
+		}
+
+		b2RevoluteJointDef jd;
+		jd.Initialize(a, b, a->GetPosition());
+		if (j.hasMotor)
+		{
+			jd.motorSpeed = j.motorSpeed;
+			jd.maxMotorTorque = j.maxMotorTorque;
+			jd.enableMotor = j.enableMotor;
+		}
+		world->CreateJoint(&jd);
+	}
+}
+
+static int32 FindLevels(const char* dir, Scene* scenes, int32 capacity)
+{
+	int32 count = 0;
+#if defined(_WIN32)
+	char pattern[256];
+	sprintf(pattern, "%s/*.xml", dir);
+	_finddata_t data;
+	intptr_t handle = _findfirst(pattern, &data);
+	if (handle == -1)
+	{
+		return 0;
+	}
+	do
+	{
+		const char* file = data.name;
+#else
+	DIR* handle = opendir(dir);
+	if (handle == NULL)
+	{
+		return 0;
+	}
+	for (dirent* entry = readdir(handle); entry; entry = readdir(handle))
+	{
+		const char* file = entry->d_name;
+		size_t length = strlen(file);
+		if (length < 5 || strcmp(file + length - 4, ".xml") != 0)
+		{
+			continue;
+		}
+#endif
+		if (count == capacity)
+		{
+			break;
+		}
+
+		Scene* scene = scenes + count++;
+		snprintf(scene->name, sizeof(scene->name), "level:%.*s", int(strlen(file) - 4), file);
+		snprintf(scene->path, sizeof(scene->path), "%s/%s", dir, file);
+		scene->create = CreateLevel;
+		scene->update = NULL;
+#if defined(_WIN32)
+	}
+	while (_findnext(handle, &data) == 0);
+	_findclose(handle);
+#else
+	}
+	closedir(handle);
+#endif
+
+	// Directory order is arbitrary.
+	for (int32 i = 1; i < count; ++i)
+	{
+		for (int32 j = i; j > 0 && strcmp(scenes[j - 1].name, scenes[j].name) > 0; --j)
+		{
+			b2Swap(scenes[j - 1], scenes[j]);
+		}
+	}
+	return count;
+}
+
+// Resident memory from /proc, in kilobytes. Writing 5 to clear_refs resets
+// the high water mark so each scene gets its own peak. Zero elsewhere.
+static int32 ReadMemoryStatus(const char* key)
+{
+#if defined(__linux__)
+	FILE* file = fopen("/proc/self/status", "r");
+	if (file == NULL)
+	{
+		return 0;
+	}
+
+	char line[256];
+	int32 value = 0;
+	size_t keyLength = strlen(key);
+	while (fgets(line, sizeof(line), file))
+	{
+		if (strncmp(line, key, keyLength) == 0 && line[keyLength] == ':')
+		{
+			value = atoi(line + keyLength + 1);
+			break;
+		}
+	}
+	fclose(file);
+	return value;
+#else
+	B2_NOT_USED(key);
+	return 0;
+#endif
+}
+
+static void ResetPeakMemory()
+{
+#if defined(__linux__)
+	FILE* file = fopen("/proc/self/clear_refs", "w");
+	if (file)
+	{
+		fputs("5", file);
+		fclose(file);
+	}
+#endif
+}
+
+struct PhaseResult
+{
+	const char* name;
+	float32 b2Profile::*timer;
+	b2HardwareCounters b2Profile::*counters;
+	float64 totalMs;
+	b2HardwareCounters totalCounters;
+};
+
+struct SceneResult
+{
+	char name[64];
+	int32 frames;
+	int32 bodies;
+	int32 contacts;
+	int32 joints;
+	float64 buildMs;
+	float64 meanMs;
+	float64 p50Ms;
+	float64 p99Ms;
+	float64 maxMs;
+	int32 baseMemoryKB;		// resident before the scene was built
+	int32 peakMemoryKB;		// resident high water mark while it ran
+	PhaseResult phases[7];
+};
+
+static void RunScene(const Scene* scene, int32 frames, SceneResult* result)
+{
+	s_seed = 1;
+	for (const char* s = scene->name; *s; ++s)
+	{
+		s_seed = 31 * s_seed + uint32(*s);
+	}
+
+	ResetPeakMemory();
+	result->baseMemoryKB = ReadMemoryStatus("VmRSS");
+
+	b2Timer buildTimer;
+	b2World* world = new b2World(b2Vec2(0.0f, -10.0f));
+	world->SetHardwareCounters(true);
+	scene->create(world, scene);
+	result->buildMs = buildTimer.GetMilliseconds();
+
+	const PhaseResult phases[7] =
+	{
+		{ "collide", &b2Profile::collide, &b2Profile::collideCounters, 0.0, {0, 0, 0, 0, 0} },
+		{ "solveInit", &b2Profile::solveInit, &b2Profile::solveInitCounters, 0.0, {0, 0, 0, 0, 0} },
+		{ "solveVelocity", &b2Profile::solveVelocity, &b2Profile::solveVelocityCounters, 0.0, {0, 0, 0, 0, 0} },
+		{ "solvePosition", &b2Profile::solvePosition, &b2Profile::solvePositionCounters, 0.0, {0, 0, 0, 0, 0} },
+		{ "broadphase", &b2Profile::broadphase, &b2Profile::broadphaseCounters, 0.0, {0, 0, 0, 0, 0} },
+		{ "solveTOI", &b2Profile::solveTOI, &b2Profile::solveTOICounters, 0.0, {0, 0, 0, 0, 0} },
+		{ "solve", &b2Profile::solve, &b2Profile::solveCounters, 0.0, {0, 0, 0, 0, 0} }
+	};
+	memcpy(result->phases, phases, sizeof(phases));
+
+	std::vector<float64> stepMs(frames);
+	float64 totalMs = 0.0;
+	for (int32 frame = 0; frame < frames; ++frame)
+	{
+		if (scene->update)
+		{
+			scene->update(world, frame);
+		}
+
+		b2Timer timer;
+		world->Step(1.0f / 60.0f, 8, 3);
+		stepMs[frame] = float64(timer.GetNanoseconds()) * 1.0e-6;
+		totalMs += stepMs[frame];
+
+		const b2Profile& profile = world->GetProfile();
+		for (int32 i = 0; i < 7; ++i)
+		{
+			PhaseResult* phase = result->phases + i;
+			phase->totalMs += profile.*(phase->timer);
+			if (phase->counters)
+			{
+				b2AddCounters(&phase->totalCounters, profile.*(phase->counters));
+			}
+		}
+	}
+
+	strcpy(result->name, scene->name);
+	result->frames = frames;
+	result->bodies = world->GetBodyCount();
+	result->contacts = world->GetContactCount();
+	result->joints = world->GetJointCount();
+	result->meanMs = frames > 0 ? totalMs / frames : 0.0;
+
+	// Nearest rank percentiles.
+	std::sort(stepMs.begin(), stepMs.end());
+	result->p50Ms = frames > 0 ? stepMs[(frames - 1) / 2] : 0.0;
+	result->p99Ms = frames > 0 ? stepMs[b2Min(frames - 1, (99 * frames + 99) / 100 - 1)] : 0.0;
+	result->maxMs = frames > 0 ? stepMs[frames - 1] : 0.0;
+
+	result->peakMemoryKB = ReadMemoryStatus("VmHWM");
+	delete world;
+}
+
+static void WriteJson(FILE* file, const SceneResult* results, int32 count, int32 frames, bool counters)
+{
+	// One scene per line keeps the file easy to diff and to read back in ReadBaseline.
+	fprintf(file, "{\n  \"benchmark\": \"scenes\",\n  \"frames\": %d,\n  \"scenes\": [\n", frames);
+	for (int32 i = 0; i < count; ++i)
+	{
+		const SceneResult* r = results + i;
+		fprintf(file, "    {\"name\": \"%s\", \"bodies\": %d, \"contacts\": %d, \"joints\": %d, \"buildMs\": %.3f, "
+			"\"meanMs\": %.4f, \"p50Ms\": %.4f, \"p99Ms\": %.4f, \"maxMs\": %.4f, \"baseMemoryKB\": %d, \"peakMemoryKB\": %d, \"phases\": {",
+			r->name, r->bodies, r->contacts, r->joints, r->buildMs,
+			r->meanMs, r->p50Ms, r->p99Ms, r->maxMs, r->baseMemoryKB, r->peakMemoryKB);
+		for (int32 j = 0; j < 7; ++j)
+		{
+			const PhaseResult* phase = r->phases + j;
+			fprintf(file, "%s\"%s\": {\"meanMs\": %.4f", j > 0 ? ", " : "", phase->name, r->frames > 0 ? phase->totalMs / r->frames : 0.0);
+			if (counters && phase->counters)
+			{
+				const b2HardwareCounters& c = phase->totalCounters;
+				fprintf(file, ", \"cycles\": %llu, \"ipc\": %.3f, \"l1dMisses\": %llu, \"llcMisses\": %llu, \"branchMisses\": %llu",
+					c.cycles, c.cycles > 0 ? float64(c.instructions) / c.cycles : 0.0, c.l1dMisses, c.llcMisses, c.branchMisses);
+			}
+			fprintf(file, "}");
+		}
+		fprintf(file, "}}%s\n", i + 1 < count ? "," : "");
+	}
+	fprintf(file, "  ]\n}\n");
+}
+
+struct BaselineEntry
+{
+	char name[64];
+	float64 meanMs;
+	float64 p50Ms;
+	float64 p99Ms;
+};
+
+static float64 ReadNumber(const char* line, const char* key)
+{
+	const char* s = strstr(line, key);
+	return s ? atof(s + strlen(key)) : 0.0;
+}
+
+static int32 ReadBaseline(const char* path, BaselineEntry* entries, int32 capacity)
+{
+	FILE* file = fopen(path, "r");
+	if (file == NULL)
+	{
+		return -1;
+	}
+
+	int32 count = 0;
+	char line[4096];
+	while (count < capacity && fgets(line, sizeof(line), file))
+	{
+		const char* name = strstr(line, "{\"name\": \"");
+		if (name == NULL)
+		{
+			continue;
+		}
+
+		name += strlen("{\"name\": \"");
+		const char* end = strchr(name, '"');
+		if (end == NULL)
+		{
+			continue;
+		}
+
+		BaselineEntry* entry = entries + count++;
+		int32 length = b2Min(int32(end - name), int32(sizeof(entry->name)) - 1);
+		memcpy(entry->name, name, length);
+		entry->name[length] = 0;
+		entry->meanMs = ReadNumber(line, "\"meanMs\": ");
+		entry->p50Ms = ReadNumber(line, "\"p50Ms\": ");
+		entry->p99Ms = ReadNumber(line, "\"p99Ms\": ");
+	}
+	fclose(file);
+	return count;
+}
+
+// Prints the change of each scene and returns the number of scenes whose
+// median or mean got slower by more than the threshold.
+static int32 Compare(const SceneResult* results, int32 count, const BaselineEntry* baseline, int32 baselineCount, float64 threshold)
+{
+	int32 regressions = 0;
+	printf("\n%-24s %12s %12s %8s %12s %12s %8s\n", "vs baseline", "base p50", "p50", "change", "base mean", "mean", "change");
+	for (int32 i = 0; i < count; ++i)
+	{
+		const SceneResult* r = results + i;
+		const BaselineEntry* b = NULL;
+		for (int32 j = 0; j < baselineCount; ++j)
+		{
+			if (strcmp(baseline[j].name, r->name) == 0)
+			{
+				b = baseline + j;
+			}
+		}
+
+		if (b == NULL)
+		{
+			printf("%-24s not in baseline\n", r->name);
+			continue;
+		}
+
+		float64 p50Change = b->p50Ms > 0.0 ? 100.0 * (r->p50Ms - b->p50Ms) / b->p50Ms : 0.0;
+		float64 meanChange = b->meanMs > 0.0 ? 100.0 * (r->meanMs - b->meanMs) / b->meanMs : 0.0;
+		bool regressed = p50Change > threshold || meanChange > threshold;
+		regressions += regressed ? 1 : 0;
+		printf("%-24s %12.3f %12.3f %+7.1f%% %12.3f %12.3f %+7.1f%%%s\n", r->name,
+			b->p50Ms, r->p50Ms, p50Change, b->meanMs, r->meanMs, meanChange, regressed ? "  REGRESSION" : "");
+	}
+	return regressions;
+}
+
+int main(int argc, char** argv)
+{
+	int32 frames = 600;
+	const char* filter = NULL;
+	const char* levelsDir = BOX2D_LEVELS_DIR;
+	const char* jsonPath = NULL;
+	const char* baselinePath = NULL;
+	float64 threshold = 5.0;
+	for (int32 i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			frames = b2Max(1, atoi(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--scene") == 0 && i + 1 < argc)
+		{
+			filter = argv[++i];
+		}
+		else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc)
+		{
+			levelsDir = argv[++i];
+		}
+		else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc)
+		{
+			jsonPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+		{
+			baselinePath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc)
+		{
+			threshold = atof(argv[++i]);
+		}
+		else
+		{
+			fprintf(stderr, "usage: %s [--frames n] [--scene substring] [--levels dir] [--json file] "
+				"[--baseline file] [--threshold percent]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const int32 maxScenes = 64;
+	Scene scenes[maxScenes];
+	const Scene builtIn[5] =
+	{
+		{ "pyramid", "", CreatePyramid, NULL },
+		{ "tumbler", "", CreateTumbler, NULL },
+		{ "ragdolls", "", CreateRagdolls, NULL },
+		{ "bullets", "", CreateBullets, UpdateBullets },
+		{ "terrain", "", CreateTerrain, NULL }
+	};
+	memcpy(scenes, builtIn, sizeof(builtIn));
+	int32 sceneCount = 5 + FindLevels(levelsDir, scenes + 5, maxScenes - 5);
+	if (sceneCount == 5)
+	{
+		fprintf(stderr, "no levels found in %s\n", levelsDir);
+	}
+
+	SceneResult* results = new SceneResult[sceneCount];
+	int32 resultCount = 0;
+	bool counters = false;
+
+	printf("%-24s %7s %8s %10s %10s %10s %10s %10s %10s\n", "scene", "bodies", "contacts", "mean ms", "p50 ms", "p99 ms", "max ms", "peak KB", "build ms");
+	for (int32 i = 0; i < sceneCount; ++i)
+	{
+		if (filter && strstr(scenes[i].name, filter) == NULL)
+		{
+			continue;
+		}
+
+		SceneResult* r = results + resultCount++;
+		RunScene(scenes + i, frames, r);
+		counters = counters || r->phases[0].totalCounters.cycles > 0;
+		printf("%-24s %7d %8d %10.3f %10.3f %10.3f %10.3f %10d %10.1f\n", r->name, r->bodies, r->contacts,
+			r->meanMs, r->p50Ms, r->p99Ms, r->maxMs, r->peakMemoryKB, r->buildMs);
+		fflush(stdout);
+	}
+
+	if (jsonPath)
+	{
+		FILE* file = fopen(jsonPath, "w");
+		if (file)
+		{
+			WriteJson(file, results, resultCount, frames, counters);
+			fclose(file);
+		}
+		else
+		{
+			fprintf(stderr, "cannot write %s\n", jsonPath);
+		}
+	}
+
+	int32 status = 0;
+	if (baselinePath)
+	{
+		BaselineEntry baseline[maxScenes];
+		int32 baselineCount = ReadBaseline(baselinePath, baseline, maxScenes);
+		if (baselineCount < 0)
+		{
+			fprintf(stderr, "cannot read %s\n", baselinePath);
+			status = 1;
+		}
+		else if (Compare(results, resultCount, baseline, baselineCount, threshold) > 0)
+		{
+			status = 2;
+		}
+	}
+
+	delete [] results;
+	return status;
+}
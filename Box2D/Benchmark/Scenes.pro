@@ -0,0 +1,20 @@
+# Stress scene and level benchmark. Build Box2D.pro first, this links lib/libBox2D.a.
+QT -= core \
+      gui
+
+TEMPLATE = app
+TARGET = Scenes
+
+CONFIG += console release warn_on
+CONFIG -= app_bundle
+
+DESTDIR = ../bin
+OBJECTS_DIR = tmp
+
+INCLUDEPATH += ../..
+QMAKE_LIBDIR += ../lib
+LIBS += -lBox2D
+PRE_TARGETDEPS += ../lib/libBox2D.a
+
+SOURCES += Scenes.cpp
+DEFINES += BOX2D_LEVELS_DIR=\\\"$$PWD/../../data/levels\\\"
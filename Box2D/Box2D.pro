@@ -9,6 +9,10 @@ CONFIG += debug staticlib warn_on
 #QMAKE_CXXFLAGS_RELEASE -= -O2
 #QMAKE_CXXFLAGS_RELEASE += -O3 -march=native -mtune=native -fomit-frame-pointer
 
+# Timeline tracing, see Common/b2Trace.h. Enable it in QBox2D.pro as well.
+#CONFIG += c++11
+#DEFINES += B2_TRACE
+
 DESTDIR = lib
 MOC_DIR = tmp
 OBJECTS_DIR = tmp
@@ -30,9 +34,11 @@ HEADERS += Box2D.h \
 	Common/b2Draw.h \
 	Common/b2GrowableStack.h \
 	Common/b2Math.h \
+	Common/b2PerfCounters.h \
 	Common/b2Settings.h \
 	Common/b2StackAllocator.h \
 	Common/b2Timer.h \
+	Common/b2Trace.h \
 	Dynamics/b2Body.h \
 	Dynamics/b2ContactManager.h \
 	Dynamics/b2Fixture.h \
@@ -79,9 +85,11 @@ SOURCES += Collision/b2BroadPhase.cpp \
 	Common/b2BlockAllocator.cpp \
 	Common/b2Draw.cpp \
 	Common/b2Math.cpp \
+	Common/b2PerfCounters.cpp \
 	Common/b2Settings.cpp \
 	Common/b2StackAllocator.cpp \
 	Common/b2Timer.cpp \
+	Common/b2Trace.cpp \
 	Dynamics/b2Body.cpp \
 	Dynamics/b2ContactManager.cpp \
 	Dynamics/b2Fixture.cpp \
@@ -49,6 +49,10 @@ public:
 	/// UpdatePairs is called.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create many proxies at once, see b2DynamicTree::CreateProxies.
+	/// Pairs are not reported until UpdatePairs is called.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. It is up to the client to remove any pairs.
 	void DestroyProxy(int32 proxyId);
 
@@ -99,6 +103,14 @@ public:
 	/// Get the quality metric of the embedded tree.
 	float32 GetTreeQuality() const;
 
+	/// Get the rotation and re-insert counters of the embedded tree.
+	/// See b2DynamicTree::GetRotationCount and b2DynamicTree::GetReinsertCount.
+	int32 GetTreeRotationCount() const;
+	int32 GetTreeReinsertCount() const;
+
+	/// Reset the counters of the embedded tree.
+	void ResetTreeCounters();
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -181,6 +193,21 @@ inline float32 b2BroadPhase::GetTreeQuality() const
 	return m_tree.GetAreaRatio();
 }
 
+inline int32 b2BroadPhase::GetTreeRotationCount() const
+{
+	return m_tree.GetRotationCount();
+}
+
+inline int32 b2BroadPhase::GetTreeReinsertCount() const
+{
+	return m_tree.GetReinsertCount();
+}
+
+inline void b2BroadPhase::ResetTreeCounters()
+{
+	m_tree.ResetCounters();
+}
+
 template <typename T>
 void b2BroadPhase::UpdatePairs(T* callback)
 {
@@ -18,6 +18,18 @@
 
 #include <Box2D/Collision/b2Collision.h>
 #include <Box2D/Collision/Shapes/b2PolygonShape.h>
+#if defined(B2_USE_SSE)
+#include <xmmintrin.h>
+#endif
+
+// The SSE and the scalar separations round alike only without fused
+// multiply-adds, which -march flags with FMA would otherwise allow. The
+// Kernels benchmark checks that the manifolds match.
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
 
 // Find the separation between poly1 and poly2 for a give edge normal on poly1.
 static float32 b2EdgeSeparation(const b2PolygonShape* poly1, const b2Transform& xf1, int32 edge1,
@@ -55,6 +67,103 @@ static float32 b2EdgeSeparation(const b2PolygonShape* poly1, const b2Transform&
 	return separation;
 }
 
+#if defined(B2_USE_SSE)
+// Compute b2EdgeSeparation for every edge normal of poly1, four normals per pass,
+// testing each batch against all vertices of poly2. The arithmetic is done in the
+// same order as b2EdgeSeparation so the results are bit-for-bit identical.
+static void b2EdgeSeparations(float32* separations,
+							  const b2PolygonShape* poly1, const b2Transform& xf1,
+							  const b2PolygonShape* poly2, const b2Transform& xf2)
+{
+	int32 count1 = poly1->m_count;
+	const b2Vec2* vertices1 = poly1->m_vertices;
+	const b2Vec2* normals1 = poly1->m_normals;
+
+	int32 count2 = poly2->m_count;
+	const b2Vec2* vertices2 = poly2->m_vertices;
+
+	const __m128 c1 = _mm_set1_ps(xf1.q.c);
+	const __m128 s1 = _mm_set1_ps(xf1.q.s);
+	const __m128 px1 = _mm_set1_ps(xf1.p.x);
+	const __m128 py1 = _mm_set1_ps(xf1.p.y);
+	const __m128 c2 = _mm_set1_ps(xf2.q.c);
+	const __m128 s2 = _mm_set1_ps(xf2.q.s);
+	const __m128 ns2 = _mm_set1_ps(-xf2.q.s);
+	const __m128 px2 = _mm_set1_ps(xf2.p.x);
+	const __m128 py2 = _mm_set1_ps(xf2.p.y);
+
+	for (int32 base = 0; base < count1; base += 4)
+	{
+		// Gather four edges. Lanes past the last edge repeat it and are discarded.
+		float32 nx[4], ny[4], vx[4], vy[4];
+		for (int32 k = 0; k < 4; ++k)
+		{
+			int32 edge = b2Min(base + k, count1 - 1);
+			nx[k] = normals1[edge].x;
+			ny[k] = normals1[edge].y;
+			vx[k] = vertices1[edge].x;
+			vy[k] = vertices1[edge].y;
+		}
+
+		__m128 n1x = _mm_loadu_ps(nx);
+		__m128 n1y = _mm_loadu_ps(ny);
+
+		// Convert normals from poly1's frame into poly2's frame.
+		__m128 nwx = _mm_sub_ps(_mm_mul_ps(c1, n1x), _mm_mul_ps(s1, n1y));
+		__m128 nwy = _mm_add_ps(_mm_mul_ps(s1, n1x), _mm_mul_ps(c1, n1y));
+		__m128 nlx = _mm_add_ps(_mm_mul_ps(c2, nwx), _mm_mul_ps(s2, nwy));
+		__m128 nly = _mm_add_ps(_mm_mul_ps(ns2, nwx), _mm_mul_ps(c2, nwy));
+
+		// Find support vertices on poly2 for -normal. Strict comparison keeps
+		// the first minimum, like the scalar loop.
+		__m128 minDot = _mm_set1_ps(b2_maxFloat);
+		__m128 sx = _mm_set1_ps(vertices2[0].x);
+		__m128 sy = _mm_set1_ps(vertices2[0].y);
+		for (int32 i = 0; i < count2; ++i)
+		{
+			__m128 x = _mm_set1_ps(vertices2[i].x);
+			__m128 y = _mm_set1_ps(vertices2[i].y);
+			__m128 dot = _mm_add_ps(_mm_mul_ps(x, nlx), _mm_mul_ps(y, nly));
+			__m128 less = _mm_cmplt_ps(dot, minDot);
+			minDot = _mm_or_ps(_mm_and_ps(less, dot), _mm_andnot_ps(less, minDot));
+			sx = _mm_or_ps(_mm_and_ps(less, x), _mm_andnot_ps(less, sx));
+			sy = _mm_or_ps(_mm_and_ps(less, y), _mm_andnot_ps(less, sy));
+		}
+
+		__m128 v1x = _mm_loadu_ps(vx);
+		__m128 v1y = _mm_loadu_ps(vy);
+		__m128 w1x = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c1, v1x), _mm_mul_ps(s1, v1y)), px1);
+		__m128 w1y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s1, v1x), _mm_mul_ps(c1, v1y)), py1);
+		__m128 w2x = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(c2, sx), _mm_mul_ps(s2, sy)), px2);
+		__m128 w2y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s2, sx), _mm_mul_ps(c2, sy)), py2);
+
+		__m128 separation = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(w2x, w1x), nwx),
+									   _mm_mul_ps(_mm_sub_ps(w2y, w1y), nwy));
+
+		float32 result[4];
+		_mm_storeu_ps(result, separation);
+		int32 n = b2Min(4, count1 - base);
+		for (int32 k = 0; k < n; ++k)
+		{
+			separations[base + k] = result[k];
+		}
+	}
+}
+#endif
+
+// Separation for one edge normal, from the precomputed table when there is one.
+static inline float32 b2GetEdgeSeparation(const float32* separations,
+								   const b2PolygonShape* poly1, const b2Transform& xf1, int32 edge1,
+								   const b2PolygonShape* poly2, const b2Transform& xf2)
+{
+	if (separations)
+	{
+		return separations[edge1];
+	}
+
+	return b2EdgeSeparation(poly1, xf1, edge1, poly2, xf2);
+}
+
 // Find the max separation between poly1 and poly2 using edge normals from poly1.
 static float32 b2FindMaxSeparation(int32* edgeIndex,
 								 const b2PolygonShape* poly1, const b2Transform& xf1,
@@ -63,6 +172,13 @@ static float32 b2FindMaxSeparation(int32* edgeIndex,
 	int32 count1 = poly1->m_count;
 	const b2Vec2* normals1 = poly1->m_normals;
 
+	const float32* separations = NULL;
+#if defined(B2_USE_SSE)
+	float32 separationBuffer[b2_maxPolygonVertices];
+	b2EdgeSeparations(separationBuffer, poly1, xf1, poly2, xf2);
+	separations = separationBuffer;
+#endif
+
 	// Vector pointing from the centroid of poly1 to the centroid of poly2.
 	b2Vec2 d = b2Mul(xf2, poly2->m_centroid) - b2Mul(xf1, poly1->m_centroid);
 	b2Vec2 dLocal1 = b2MulT(xf1.q, d);
@@ -81,15 +197,15 @@ static float32 b2FindMaxSeparation(int32* edgeIndex,
 	}
 
 	// Get the separation for the edge normal.
-	float32 s = b2EdgeSeparation(poly1, xf1, edge, poly2, xf2);
+	float32 s = b2GetEdgeSeparation(separations, poly1, xf1, edge, poly2, xf2);
 
 	// Check the separation for the previous edge normal.
 	int32 prevEdge = edge - 1 >= 0 ? edge - 1 : count1 - 1;
-	float32 sPrev = b2EdgeSeparation(poly1, xf1, prevEdge, poly2, xf2);
+	float32 sPrev = b2GetEdgeSeparation(separations, poly1, xf1, prevEdge, poly2, xf2);
 
 	// Check the separation for the next edge normal.
 	int32 nextEdge = edge + 1 < count1 ? edge + 1 : 0;
-	float32 sNext = b2EdgeSeparation(poly1, xf1, nextEdge, poly2, xf2);
+	float32 sNext = b2GetEdgeSeparation(separations, poly1, xf1, nextEdge, poly2, xf2);
 
 	// Find the best edge and the search direction.
 	int32 bestEdge;
@@ -121,7 +237,7 @@ static float32 b2FindMaxSeparation(int32* edgeIndex,
 		else
 			edge = bestEdge + 1 < count1 ? bestEdge + 1 : 0;
 
-		s = b2EdgeSeparation(poly1, xf1, edge, poly2, xf2);
+		s = b2GetEdgeSeparation(separations, poly1, xf1, edge, poly2, xf2);
 
 		if (s > bestSeparation)
 		{
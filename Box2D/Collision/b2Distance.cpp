@@ -601,3 +601,25 @@ void b2Distance(b2DistanceOutput* output,
 		}
 	}
 }
+
+void b2DistanceBatch(b2DistanceOutput* outputs,
+					 b2SimplexCache* caches,
+					 const b2DistanceInput* inputs,
+					 int32 count)
+{
+	// The shapes of a batch are usually scattered over the heap. Fetch the
+	// vertices of the pairs ahead while the current pair is solved.
+	const int32 k_prefetchDistance = 2;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (i + k_prefetchDistance < count)
+		{
+			const b2DistanceInput* next = inputs + i + k_prefetchDistance;
+			b2Prefetch(next->proxyA.m_vertices);
+			b2Prefetch(next->proxyB.m_vertices);
+			b2Prefetch(caches + i + k_prefetchDistance);
+		}
+
+		b2Distance(outputs + i, caches + i, inputs + i);
+	}
+}
@@ -90,6 +90,16 @@ void b2Distance(b2DistanceOutput* output,
 				b2SimplexCache* cache, 
 				const b2DistanceInput* input);
 
+/// Compute the closest points for an array of shape pairs. Same results as calling
+/// b2Distance on each pair. The simplex caches are input/output.
+/// The pairs are still solved one at a time with the scalar GJK; the batch only
+/// prefetches the vertices of upcoming pairs, which pays off when the shapes
+/// are scattered over the heap. See Benchmark/DistanceBatch.cpp.
+void b2DistanceBatch(b2DistanceOutput* outputs,
+					 b2SimplexCache* caches,
+					 const b2DistanceInput* inputs,
+					 int32 count);
+
 
 //////////////////////////////////////////////////////////////////////////
 
@@ -19,6 +19,7 @@
 #include <Box2D/Collision/b2DynamicTree.h>
 #include <cstring>
 #include <cfloat>
+#include <algorithm>
 using namespace std;
 
 
@@ -44,6 +45,9 @@ b2DynamicTree::b2DynamicTree()
 	m_path = 0;
 
 	m_insertionCount = 0;
+
+	m_rotationCount = 0;
+	m_reinsertCount = 0;
 }
 
 b2DynamicTree::~b2DynamicTree()
@@ -59,24 +63,7 @@ int32 b2DynamicTree::AllocateNode()
 	if (m_freeList == b2_nullNode)
 	{
 		b2Assert(m_nodeCount == m_nodeCapacity);
-
-		// The free list is empty. Rebuild a bigger pool.
-		b2TreeNode* oldNodes = m_nodes;
-		m_nodeCapacity *= 2;
-		m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
-		memcpy(m_nodes, oldNodes, m_nodeCount * sizeof(b2TreeNode));
-		b2Free(oldNodes);
-
-		// Build a linked list for the free list. The parent
-		// pointer becomes the "next" pointer.
-		for (int32 i = m_nodeCount; i < m_nodeCapacity - 1; ++i)
-		{
-			m_nodes[i].next = i + 1;
-			m_nodes[i].height = -1;
-		}
-		m_nodes[m_nodeCapacity-1].next = b2_nullNode;
-		m_nodes[m_nodeCapacity-1].height = -1;
-		m_freeList = m_nodeCount;
+		ReserveNodes(2 * m_nodeCapacity);
 	}
 
 	// Peel a node off the free list.
@@ -91,6 +78,35 @@ int32 b2DynamicTree::AllocateNode()
 	return nodeId;
 }
 
+// Grow the pool so that it holds at least the given number of nodes.
+void b2DynamicTree::ReserveNodes(int32 capacity)
+{
+	if (capacity <= m_nodeCapacity)
+	{
+		return;
+	}
+
+	// Rebuild a bigger pool.
+	int32 oldCapacity = m_nodeCapacity;
+	b2TreeNode* oldNodes = m_nodes;
+	m_nodeCapacity = b2Max(capacity, 2 * m_nodeCapacity);
+	m_nodes = (b2TreeNode*)b2Alloc(m_nodeCapacity * sizeof(b2TreeNode));
+	memcpy(m_nodes, oldNodes, oldCapacity * sizeof(b2TreeNode));
+	b2Free(oldNodes);
+
+	// Build a linked list for the free list. The parent
+	// pointer becomes the "next" pointer. The new nodes go in
+	// front of any nodes that are still free in the old pool.
+	for (int32 i = oldCapacity; i < m_nodeCapacity - 1; ++i)
+	{
+		m_nodes[i].next = i + 1;
+		m_nodes[i].height = -1;
+	}
+	m_nodes[m_nodeCapacity-1].next = m_freeList;
+	m_nodes[m_nodeCapacity-1].height = -1;
+	m_freeList = oldCapacity;
+}
+
 // Return a node to the pool.
 void b2DynamicTree::FreeNode(int32 nodeId)
 {
@@ -121,6 +137,46 @@ int32 b2DynamicTree::CreateProxy(const b2AABB& aabb, void* userData)
 	return proxyId;
 }
 
+void b2DynamicTree::CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	// Rebuilding costs O(n log n) in the total leaf count, so only do it when
+	// the batch is at least as large as what is already in the tree.
+	int32 leafCount = (m_nodeCount + 1) / 2;
+	bool rebuild = count >= leafCount;
+
+	ReserveNodes(m_nodeCount + 2 * count);
+
+	b2Vec2 r(b2_aabbExtension, b2_aabbExtension);
+	for (int32 i = 0; i < count; ++i)
+	{
+		int32 proxyId = AllocateNode();
+
+		// Fatten the aabb.
+		m_nodes[proxyId].aabb.lowerBound = aabbs[i].lowerBound - r;
+		m_nodes[proxyId].aabb.upperBound = aabbs[i].upperBound + r;
+		m_nodes[proxyId].userData = userData[i];
+		m_nodes[proxyId].height = 0;
+
+		if (rebuild == false)
+		{
+			InsertLeaf(proxyId);
+		}
+
+		proxyIds[i] = proxyId;
+	}
+
+	if (rebuild)
+	{
+		m_insertionCount += count;
+		RebuildTopDown();
+	}
+}
+
 void b2DynamicTree::DestroyProxy(int32 proxyId)
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
@@ -173,6 +229,7 @@ bool b2DynamicTree::MoveProxy(int32 proxyId, const b2AABB& aabb, const b2Vec2& d
 	m_nodes[proxyId].aabb = b;
 
 	InsertLeaf(proxyId);
+	b2ProfileCount(m_reinsertCount, 1);
 	return true;
 }
 
@@ -400,6 +457,8 @@ int32 b2DynamicTree::Balance(int32 iA)
 	// Rotate C up
 	if (balance > 1)
 	{
+		b2ProfileCount(m_rotationCount, 1);
+
 		int32 iF = C->child1;
 		int32 iG = C->child2;
 		b2TreeNode* F = m_nodes + iF;
@@ -460,6 +519,8 @@ int32 b2DynamicTree::Balance(int32 iA)
 	// Rotate B up
 	if (balance < -1)
 	{
+		b2ProfileCount(m_rotationCount, 1);
+
 		int32 iD = B->child1;
 		int32 iE = B->child2;
 		b2TreeNode* D = m_nodes + iD;
@@ -770,6 +831,103 @@ void b2DynamicTree::RebuildBottomUp()
 	Validate();
 }
 
+// Orders leaves by the center of their AABB along one axis.
+struct b2TreeCenterLessThan
+{
+	bool operator()(const b2TreeBuildLeaf& a, const b2TreeBuildLeaf& b) const
+	{
+		return a.center(axis) < b.center(axis);
+	}
+
+	int32 axis;
+};
+
+// Build a sub-tree over the given leaves and return its root. The leaves
+// are split at the median center along the longest axis of their centers.
+int32 b2DynamicTree::BuildTopDown(b2TreeBuildLeaf* leaves, int32 count)
+{
+	if (count == 1)
+	{
+		return leaves[0].index;
+	}
+
+	b2Vec2 lower = leaves[0].center;
+	b2Vec2 upper = lower;
+	for (int32 i = 1; i < count; ++i)
+	{
+		lower = b2Min(lower, leaves[i].center);
+		upper = b2Max(upper, leaves[i].center);
+	}
+
+	b2TreeCenterLessThan lessThan;
+	lessThan.axis = (upper.x - lower.x) >= (upper.y - lower.y) ? 0 : 1;
+
+	int32 mid = count / 2;
+	std::nth_element(leaves, leaves + mid, leaves + count, lessThan);
+
+	int32 index1 = BuildTopDown(leaves, mid);
+	int32 index2 = BuildTopDown(leaves + mid, count - mid);
+
+	// Allocation can grow the pool, so take node pointers afterwards.
+	int32 parentIndex = AllocateNode();
+	b2TreeNode* parent = m_nodes + parentIndex;
+	b2TreeNode* child1 = m_nodes + index1;
+	b2TreeNode* child2 = m_nodes + index2;
+
+	parent->child1 = index1;
+	parent->child2 = index2;
+	parent->height = 1 + b2Max(child1->height, child2->height);
+	parent->aabb.Combine(child1->aabb, child2->aabb);
+	parent->parent = b2_nullNode;
+
+	child1->parent = parentIndex;
+	child2->parent = parentIndex;
+
+	return parentIndex;
+}
+
+void b2DynamicTree::RebuildTopDown()
+{
+	b2TreeBuildLeaf* leaves = (b2TreeBuildLeaf*)b2Alloc(m_nodeCount * sizeof(b2TreeBuildLeaf));
+	int32 count = 0;
+
+	// Build array of leaves. Free the rest.
+	for (int32 i = 0; i < m_nodeCapacity; ++i)
+	{
+		if (m_nodes[i].height < 0)
+		{
+			// free node in pool
+			continue;
+		}
+
+		if (m_nodes[i].IsLeaf())
+		{
+			m_nodes[i].parent = b2_nullNode;
+			leaves[count].center = m_nodes[i].aabb.GetCenter();
+			leaves[count].index = i;
+			++count;
+		}
+		else
+		{
+			FreeNode(i);
+		}
+	}
+
+	if (count == 0)
+	{
+		m_root = b2_nullNode;
+	}
+	else
+	{
+		// Internal nodes are allocated while building, make room for all of them.
+		ReserveNodes(2 * count - 1);
+		m_root = BuildTopDown(leaves, count);
+		m_nodes[m_root].parent = b2_nullNode;
+	}
+
+	b2Free(leaves);
+}
+
 void b2DynamicTree::ShiftOrigin(const b2Vec2& newOrigin)
 {
 	// Build array of leaves. Free the rest.
@@ -50,6 +50,13 @@ struct b2TreeNode
 	int32 height;
 };
 
+/// Leaf center and node index, used while building a tree top-down.
+struct b2TreeBuildLeaf
+{
+	b2Vec2 center;
+	int32 index;
+};
+
 /// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
 /// A dynamic tree arranges data in a binary tree to accelerate
 /// queries such as volume queries and ray casts. Leafs are proxies
@@ -70,6 +77,11 @@ public:
 	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
 	int32 CreateProxy(const b2AABB& aabb, void* userData);
 
+	/// Create many proxies at once. If the batch is large compared to the tree
+	/// the whole tree is rebuilt top-down, otherwise the leaves are inserted one by one.
+	/// @param proxyIds receives the id of each new proxy.
+	void CreateProxies(const b2AABB* aabbs, void* const* userData, int32 count, int32* proxyIds);
+
 	/// Destroy a proxy. This asserts if the id is invalid.
 	void DestroyProxy(int32 proxyId);
 
@@ -115,9 +127,23 @@ public:
 	/// Get the ratio of the sum of the node areas to the root area.
 	float32 GetAreaRatio() const;
 
+	/// Get the number of rotations done by the incremental balancing since the
+	/// last call to ResetCounters.
+	int32 GetRotationCount() const;
+
+	/// Get the number of proxies re-inserted by MoveProxy since the last call
+	/// to ResetCounters.
+	int32 GetReinsertCount() const;
+
+	/// Reset the rotation and re-insert counters.
+	void ResetCounters();
+
 	/// Build an optimal tree. Very expensive. For testing.
 	void RebuildBottomUp();
 
+	/// Build a tree top-down by median splits. O(n log n), used after bulk loads.
+	void RebuildTopDown();
+
 	/// Shift the world origin. Useful for large worlds.
 	/// The shift formula is: position -= newOrigin
 	/// @param newOrigin the new origin with respect to the old origin
@@ -126,6 +152,7 @@ public:
 private:
 
 	int32 AllocateNode();
+	void ReserveNodes(int32 capacity);
 	void FreeNode(int32 node);
 
 	void InsertLeaf(int32 node);
@@ -133,6 +160,8 @@ private:
 
 	int32 Balance(int32 index);
 
+	int32 BuildTopDown(b2TreeBuildLeaf* leaves, int32 count);
+
 	int32 ComputeHeight() const;
 	int32 ComputeHeight(int32 nodeId) const;
 
@@ -151,8 +180,27 @@ private:
 	uint32 m_path;
 
 	int32 m_insertionCount;
+
+	int32 m_rotationCount;
+	int32 m_reinsertCount;
 };
 
+inline int32 b2DynamicTree::GetRotationCount() const
+{
+	return m_rotationCount;
+}
+
+inline int32 b2DynamicTree::GetReinsertCount() const
+{
+	return m_reinsertCount;
+}
+
+inline void b2DynamicTree::ResetCounters()
+{
+	m_rotationCount = 0;
+	m_reinsertCount = 0;
+}
+
 inline void* b2DynamicTree::GetUserData(int32 proxyId) const
 {
 	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
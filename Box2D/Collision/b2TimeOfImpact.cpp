@@ -474,3 +474,20 @@ void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input)
 
 	b2_toiMaxIters = b2Max(b2_toiMaxIters, iter);
 }
+
+void b2TimeOfImpactBatch(b2TOIOutput* outputs, const b2TOIInput* inputs, int32 count)
+{
+	// See b2DistanceBatch.
+	const int32 k_prefetchDistance = 2;
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (i + k_prefetchDistance < count)
+		{
+			const b2TOIInput* next = inputs + i + k_prefetchDistance;
+			b2Prefetch(next->proxyA.m_vertices);
+			b2Prefetch(next->proxyB.m_vertices);
+		}
+
+		b2TimeOfImpact(outputs + i, inputs + i);
+	}
+}
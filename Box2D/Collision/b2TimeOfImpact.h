@@ -55,4 +55,9 @@ struct b2TOIOutput
 /// Note: use b2Distance to compute the contact point and normal at the time of impact.
 void b2TimeOfImpact(b2TOIOutput* output, const b2TOIInput* input);
 
+/// Compute the time of impact for an array of shape pairs. Same results as calling
+/// b2TimeOfImpact on each pair. Like b2DistanceBatch this is a per-pair loop that
+/// prefetches the vertices of upcoming pairs, not a SIMD kernel.
+void b2TimeOfImpactBatch(b2TOIOutput* outputs, const b2TOIInput* inputs, int32 count);
+
 #endif
@@ -0,0 +1,197 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2PerfCounters.h>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+b2PerfCounters::b2PerfCounters()
+{
+	for (int32 i = 0; i < e_counterCount; ++i)
+	{
+		m_fds[i] = -1;
+		m_slots[i] = -1;
+	}
+	m_openCount = 0;
+}
+
+b2PerfCounters::~b2PerfCounters()
+{
+	Close();
+}
+
+#if defined(__linux__)
+
+static int32 b2OpenPerfEvent(uint32 type, uint64 config, int32 groupFd)
+{
+	perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	// The group leader starts disabled and enables the whole group at once.
+	attr.disabled = groupFd == -1 ? 1 : 0;
+
+	return int32(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+bool b2PerfCounters::Open()
+{
+	Close();
+
+	const uint32 types[e_counterCount] =
+	{
+		PERF_TYPE_HARDWARE,
+		PERF_TYPE_HARDWARE,
+		PERF_TYPE_HW_CACHE,
+		PERF_TYPE_HARDWARE,
+		PERF_TYPE_HARDWARE
+	};
+
+	const uint64 configs[e_counterCount] =
+	{
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+
+	// The cycle counter leads the group. Members that fail to open are skipped.
+	for (int32 i = 0; i < e_counterCount; ++i)
+	{
+		int32 fd = b2OpenPerfEvent(types[i], configs[i], m_fds[e_cycles]);
+		if (fd < 0)
+		{
+			if (i == e_cycles)
+			{
+				return false;
+			}
+			continue;
+		}
+
+		m_fds[i] = fd;
+		m_slots[i] = m_openCount;
+		++m_openCount;
+	}
+
+	ioctl(m_fds[e_cycles], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(m_fds[e_cycles], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	return true;
+}
+
+void b2PerfCounters::Close()
+{
+	// Members first, the leader owns the group.
+	for (int32 i = e_counterCount - 1; i >= 0; --i)
+	{
+		if (m_fds[i] >= 0)
+		{
+			close(m_fds[i]);
+		}
+		m_fds[i] = -1;
+		m_slots[i] = -1;
+	}
+	m_openCount = 0;
+}
+
+void b2PerfCounters::Read(b2HardwareCounters* counters) const
+{
+	memset(counters, 0, sizeof(b2HardwareCounters));
+	if (m_openCount == 0)
+	{
+		return;
+	}
+
+	// The group reads as the number of counters, the time the group was
+	// enabled and the time it was running, then the values.
+	uint64 buffer[3 + e_counterCount];
+	ssize_t size = read(m_fds[e_cycles], buffer, sizeof(buffer));
+	if (size < ssize_t((3 + m_openCount) * sizeof(uint64)))
+	{
+		return;
+	}
+
+	// When the PMU has fewer counters than events the kernel multiplexes the
+	// group and it counts only part of the time. Extrapolate to the whole time.
+	uint64 enabled = buffer[1];
+	uint64 running = buffer[2];
+	if (running == 0)
+	{
+		return;
+	}
+	float64 scale = running < enabled ? float64(enabled) / float64(running) : 1.0;
+
+	uint64* values = buffer + 3;
+	uint64* targets[e_counterCount] =
+	{
+		&counters->cycles,
+		&counters->instructions,
+		&counters->l1dMisses,
+		&counters->llcMisses,
+		&counters->branchMisses
+	};
+
+	for (int32 i = 0; i < e_counterCount; ++i)
+	{
+		if (m_slots[i] >= 0)
+		{
+			*targets[i] = scale == 1.0 ? values[m_slots[i]] : uint64(float64(values[m_slots[i]]) * scale);
+		}
+	}
+}
+
+#else
+
+bool b2PerfCounters::Open()
+{
+	return false;
+}
+
+void b2PerfCounters::Close()
+{
+}
+
+void b2PerfCounters::Read(b2HardwareCounters* counters) const
+{
+	memset(counters, 0, sizeof(b2HardwareCounters));
+}
+
+#endif
+
+void b2PerfCounters::ReadDelta(b2HardwareCounters* delta, b2HardwareCounters* last) const
+{
+	b2HardwareCounters now;
+	Read(&now);
+	delta->cycles = now.cycles - last->cycles;
+	delta->instructions = now.instructions - last->instructions;
+	delta->l1dMisses = now.l1dMisses - last->l1dMisses;
+	delta->llcMisses = now.llcMisses - last->llcMisses;
+	delta->branchMisses = now.branchMisses - last->branchMisses;
+	*last = now;
+}
@@ -0,0 +1,106 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_PERF_COUNTERS_H
+#define B2_PERF_COUNTERS_H
+
+#include <Box2D/Common/b2Settings.h>
+
+/// Hardware event counts, user space only. Counters that could not be
+/// opened stay zero.
+struct b2HardwareCounters
+{
+	uint64 cycles;
+	uint64 instructions;
+	uint64 l1dMisses;		///< L1 data cache read misses
+	uint64 llcMisses;		///< last level cache misses
+	uint64 branchMisses;
+};
+
+/// Hardware performance counters of the calling thread, read through Linux
+/// perf_event_open. Open fails on other platforms, in virtual machines
+/// without a PMU and when kernel.perf_event_paranoid forbids it; reads are
+/// then no-ops and the counts stay zero. The counters follow the thread
+/// that opened them, so sample them on that thread only.
+class b2PerfCounters
+{
+public:
+
+	enum Counter
+	{
+		e_cycles = 0,
+		e_instructions,
+		e_l1dMisses,
+		e_llcMisses,
+		e_branchMisses,
+		e_counterCount
+	};
+
+	b2PerfCounters();
+	~b2PerfCounters();
+
+	/// Open and start the counters for the calling thread.
+	/// @return true if at least the cycle counter is available.
+	bool Open();
+
+	/// Stop and release the counters.
+	void Close();
+
+	/// Are the counters open?
+	bool IsOpen() const;
+
+	/// Is the given counter available? Some PMUs lack the cache events.
+	bool IsAvailable(Counter counter) const;
+
+	/// Read the running totals. Zero if the counters are not open. When the
+	/// kernel multiplexes the counters they are scaled by time enabled over
+	/// time running, so they are estimates.
+	void Read(b2HardwareCounters* counters) const;
+
+	/// Get the counts since last was read and update last to the running
+	/// totals. This chains the phases of a step with one read each.
+	void ReadDelta(b2HardwareCounters* delta, b2HardwareCounters* last) const;
+
+private:
+
+	int32 m_fds[e_counterCount];
+	int32 m_slots[e_counterCount];	///< position in the group read, -1 if unavailable
+	int32 m_openCount;
+};
+
+/// Add counts to a sum.
+inline void b2AddCounters(b2HardwareCounters* sum, const b2HardwareCounters& counters)
+{
+	sum->cycles += counters.cycles;
+	sum->instructions += counters.instructions;
+	sum->l1dMisses += counters.l1dMisses;
+	sum->llcMisses += counters.llcMisses;
+	sum->branchMisses += counters.branchMisses;
+}
+
+inline bool b2PerfCounters::IsOpen() const
+{
+	return m_openCount > 0;
+}
+
+inline bool b2PerfCounters::IsAvailable(Counter counter) const
+{
+	return m_slots[counter] >= 0;
+}
+
+#endif
@@ -31,9 +31,35 @@ typedef signed int int32;
 typedef unsigned char uint8;
 typedef unsigned short uint16;
 typedef unsigned int uint32;
+typedef unsigned long long uint64;
 typedef float float32;
 typedef double float64;
 
+/// SSE kernels are used for some collision routines when the target supports
+/// them. Define B2_NO_SIMD to force the scalar code paths.
+#if !defined(B2_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+#define B2_USE_SSE
+#endif
+
+/// Hint that the memory at an address will be read soon.
+#if defined(__GNUC__)
+#define b2Prefetch(address) __builtin_prefetch(address)
+#elif defined(B2_USE_SSE)
+#include <xmmintrin.h>
+#define b2Prefetch(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#else
+#define b2Prefetch(address) B2_NOT_USED(address)
+#endif
+
+/// The step counters and rolling timer statistics of b2Profile are gathered
+/// unless B2_NO_PROFILE_COUNTERS is defined. Compiled out they cost nothing.
+#if !defined(B2_NO_PROFILE_COUNTERS)
+#define B2_PROFILE_COUNTERS
+#define b2ProfileCount(counter, n) ((counter) += (n))
+#else
+#define b2ProfileCount(counter, n)
+#endif
+
 #define	b2_maxFloat		FLT_MAX
 #define	b2_epsilon		FLT_EPSILON
 #define b2_pi			3.14159265359f
@@ -52,6 +78,15 @@ typedef double float64;
 /// this too much because b2BlockAllocator has a maximum object size.
 #define b2_maxPolygonVertices	8
 
+// Profiling
+
+/// The number of steps kept for the rolling timer statistics, see b2World::SetProfileStats.
+#define b2_profileWindow		128
+
+/// The number of island size buckets in b2Profile. Bucket i counts islands
+/// with 2^i to 2^(i+1) - 1 bodies, the last bucket counts all larger islands.
+#define b2_profileIslandBuckets	8
+
 /// This is used to fatten AABBs in the dynamic tree. This allows proxies
 /// to move by a small amount without triggering a tree adjustment.
 /// This is in meters.
@@ -19,82 +19,184 @@
 #include <Box2D/Common/b2Timer.h>
 
 #if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#include <time.h>
+#elif defined(__linux__)
+#include <time.h>
+#endif
 
-float64 b2Timer::s_invFrequency = 0.0f;
+#if defined(B2_TIMER_RDTSC) && (defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64))
+#define B2_TIMER_USE_RDTSC
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
 
-#include <windows.h>
+// Read the native monotonic clock.
+static uint64 b2ReadClock()
+{
+#if defined(_WIN32)
+	LARGE_INTEGER largeInteger;
+	QueryPerformanceCounter(&largeInteger);
+	return uint64(largeInteger.QuadPart);
+#elif defined(__APPLE__)
+	return mach_absolute_time();
+#elif defined(__linux__)
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return uint64(t.tv_sec) * 1000000000ull + uint64(t.tv_nsec);
+#else
+	return 0;
+#endif
+}
 
-b2Timer::b2Timer()
+// Nanoseconds per tick of the native monotonic clock.
+static float64 b2ClockPeriod()
 {
+#if defined(_WIN32)
 	LARGE_INTEGER largeInteger;
+	QueryPerformanceFrequency(&largeInteger);
+	return largeInteger.QuadPart > 0 ? 1.0e9 / float64(largeInteger.QuadPart) : 0.0;
+#elif defined(__APPLE__)
+	mach_timebase_info_data_t info;
+	mach_timebase_info(&info);
+	return float64(info.numer) / float64(info.denom);
+#elif defined(__linux__)
+	return 1.0;
+#else
+	return 0.0;
+#endif
+}
+
+#if defined(B2_TIMER_USE_RDTSC)
 
-	if (s_invFrequency == 0.0f)
+// Measure the TSC rate against the monotonic clock. This spins for about
+// two milliseconds, once per process.
+static float64 b2CalibrateTsc()
+{
+	float64 clockPeriod = b2ClockPeriod();
+	if (clockPeriod == 0.0)
 	{
-		QueryPerformanceFrequency(&largeInteger);
-		s_invFrequency = float64(largeInteger.QuadPart);
-		if (s_invFrequency > 0.0f)
-		{
-			s_invFrequency = 1000.0f / s_invFrequency;
-		}
+		return 0.0;
 	}
 
-	QueryPerformanceCounter(&largeInteger);
-	m_start = float64(largeInteger.QuadPart);
+	uint64 clock0 = b2ReadClock();
+	uint64 tsc0 = __rdtsc();
+	uint64 clock1 = clock0;
+	while (float64(clock1 - clock0) * clockPeriod < 2.0e6)
+	{
+		clock1 = b2ReadClock();
+	}
+	uint64 tsc1 = __rdtsc();
+
+	if (tsc1 <= tsc0)
+	{
+		return 0.0;
+	}
+
+	return float64(clock1 - clock0) * clockPeriod / float64(tsc1 - tsc0);
 }
 
-void b2Timer::Reset()
+#endif
+
+static float64 b2ComputeTickPeriod()
 {
-	LARGE_INTEGER largeInteger;
-	QueryPerformanceCounter(&largeInteger);
-	m_start = float64(largeInteger.QuadPart);
+#if defined(B2_TIMER_USE_RDTSC)
+	return b2CalibrateTsc();
+#else
+	return b2ClockPeriod();
+#endif
 }
 
-float32 b2Timer::GetMilliseconds() const
+float64 b2Timer::GetTickPeriod()
 {
-	LARGE_INTEGER largeInteger;
-	QueryPerformanceCounter(&largeInteger);
-	float64 count = float64(largeInteger.QuadPart);
-	float32 ms = float32(s_invFrequency * (count - m_start));
-	return ms;
+	// Timers run on several threads. A function local static is initialized
+	// exactly once, other first callers wait for it, and it is ready even for
+	// timers constructed during static initialization of other files.
+	static const float64 s_tickPeriod = b2ComputeTickPeriod();
+	return s_tickPeriod;
 }
 
-#elif defined(__linux__) || defined (__APPLE__)
-
-#include <sys/time.h>
+uint64 b2Timer::GetTicks()
+{
+#if defined(B2_TIMER_USE_RDTSC)
+	return __rdtsc();
+#else
+	return b2ReadClock();
+#endif
+}
 
 b2Timer::b2Timer()
 {
-    Reset();
+	GetTickPeriod();
+	Reset();
 }
 
 void b2Timer::Reset()
 {
-    timeval t;
-    gettimeofday(&t, 0);
-    m_start_sec = t.tv_sec;
-    m_start_msec = t.tv_usec * 0.001f;
+	m_start = GetTicks();
 }
 
-float32 b2Timer::GetMilliseconds() const
+uint64 b2Timer::GetNanoseconds() const
 {
-    timeval t;
-    gettimeofday(&t, 0);
-    return (t.tv_sec - m_start_sec) * 1000 + t.tv_usec * 0.001f - m_start_msec;
+	uint64 ticks = GetTicks() - m_start;
+#if defined(__linux__) && !defined(B2_TIMER_USE_RDTSC)
+	return ticks;
+#else
+	return uint64(float64(ticks) * GetTickPeriod());
+#endif
 }
 
+uint64 b2Timer::GetTimestamp()
+{
+#if defined(__linux__) && !defined(B2_TIMER_USE_RDTSC)
+	return GetTicks();
 #else
+	return uint64(float64(GetTicks()) * GetTickPeriod());
+#endif
+}
 
-b2Timer::b2Timer()
+b2CpuTimer::b2CpuTimer()
 {
+	Reset();
 }
 
-void b2Timer::Reset()
+void b2CpuTimer::Reset()
 {
+	m_start = GetThreadTime();
 }
 
-float32 b2Timer::GetMilliseconds() const
+uint64 b2CpuTimer::GetNanoseconds() const
 {
-	return 0.0f;
+	return GetThreadTime() - m_start;
 }
 
+uint64 b2CpuTimer::GetThreadTime()
+{
+#if defined(_WIN32)
+	FILETIME creation, exit, kernel, user;
+	if (GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user) == 0)
+	{
+		return 0;
+	}
+
+	// FILETIME counts 100 nanosecond intervals.
+	uint64 kernelTime = (uint64(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+	uint64 userTime = (uint64(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+	return (kernelTime + userTime) * 100;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+	timespec t;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t) != 0)
+	{
+		return 0;
+	}
+
+	return uint64(t.tv_sec) * 1000000000ull + uint64(t.tv_nsec);
+#else
+	return 0;
 #endif
+}
@@ -21,8 +21,12 @@
 
 #include <Box2D/Common/b2Settings.h>
 
-/// Timer for profiling. This has platform specific code and may
-/// not work on every platform.
+/// Timer for profiling. This reads a monotonic clock with nanosecond
+/// resolution: clock_gettime(CLOCK_MONOTONIC) on Linux, mach_absolute_time
+/// on OS X and QueryPerformanceCounter on Windows. Define B2_TIMER_RDTSC to
+/// read the x86 time stamp counter instead, which is cheaper but assumes an
+/// invariant TSC. It is calibrated against the monotonic clock on first use.
+/// This has platform specific code and may not work on every platform.
 class b2Timer
 {
 public:
@@ -36,15 +40,68 @@ public:
 	/// Get the time since construction or the last reset.
 	float32 GetMilliseconds() const;
 
+	/// Get the time since construction or the last reset in microseconds.
+	float32 GetMicroseconds() const;
+
+	/// Get the time since construction or the last reset in nanoseconds.
+	uint64 GetNanoseconds() const;
+
+	/// Get a monotonic time stamp in nanoseconds. The origin is arbitrary
+	/// but the same for every caller in the process.
+	static uint64 GetTimestamp();
+
+	/// Read the raw clock behind the timer. This is the cheapest way to take
+	/// a time stamp, multiply by GetTickPeriod to get nanoseconds.
+	static uint64 GetTicks();
+
+	/// Get the length of one clock tick in nanoseconds.
+	static float64 GetTickPeriod();
+
 private:
 
-#if defined(_WIN32)
-	float64 m_start;
-	static float64 s_invFrequency;
-#elif defined(__linux__) || defined (__APPLE__)
-	unsigned long m_start_sec;
-	unsigned long m_start_msec;
-#endif
+	uint64 m_start;
+};
+
+/// Timer for the CPU time consumed by the calling thread. Comparing it with
+/// b2Timer tells time spent computing from time lost to preemption or page
+/// faults. The timer must be read on the thread that reset it. Returns zero
+/// where per-thread CPU time is not available.
+class b2CpuTimer
+{
+public:
+
+	/// Constructor
+	b2CpuTimer();
+
+	/// Reset the timer.
+	void Reset();
+
+	/// Get the thread CPU time since construction or the last reset.
+	float32 GetMilliseconds() const;
+
+	/// Get the thread CPU time since construction or the last reset in nanoseconds.
+	uint64 GetNanoseconds() const;
+
+private:
+
+	static uint64 GetThreadTime();
+
+	uint64 m_start;
 };
 
+inline float32 b2Timer::GetMilliseconds() const
+{
+	return float32(float64(GetNanoseconds()) * 1.0e-6);
+}
+
+inline float32 b2Timer::GetMicroseconds() const
+{
+	return float32(float64(GetNanoseconds()) * 1.0e-3);
+}
+
+inline float32 b2CpuTimer::GetMilliseconds() const
+{
+	return float32(float64(GetNanoseconds()) * 1.0e-6);
+}
+
 #endif
@@ -0,0 +1,199 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include <Box2D/Common/b2Trace.h>
+#include <Box2D/Common/b2Math.h>
+
+#if defined(B2_TRACE)
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+struct b2TraceEvent
+{
+	const char* name;
+	uint64 begin;
+	uint64 end;
+};
+
+// Written by its thread only. The count is published with release order so
+// the exporter sees complete events below it.
+struct b2TraceBuffer
+{
+	b2TraceEvent events[b2_traceCapacity];
+	std::atomic<uint64> count;
+	b2TraceBuffer* next;
+	int32 threadId;
+	char threadName[32];
+};
+
+// Buffers are never freed so the events of finished threads can be exported.
+static std::atomic<b2TraceBuffer*> s_traceBuffers(NULL);
+static std::atomic<int32> s_traceThreadCount(0);
+static thread_local b2TraceBuffer* s_traceBuffer = NULL;
+static char s_traceExitPath[256];
+
+static b2TraceBuffer* b2GetTraceBuffer()
+{
+	if (s_traceBuffer != NULL)
+	{
+		return s_traceBuffer;
+	}
+
+	void* mem = b2Alloc(sizeof(b2TraceBuffer));
+	b2TraceBuffer* buffer = new (mem) b2TraceBuffer;
+	buffer->count.store(0);
+	buffer->threadId = s_traceThreadCount.fetch_add(1) + 1;
+	buffer->threadName[0] = 0;
+
+	// Push onto the global list.
+	buffer->next = s_traceBuffers.load();
+	while (s_traceBuffers.compare_exchange_weak(buffer->next, buffer) == false)
+	{
+	}
+
+	s_traceBuffer = buffer;
+	return buffer;
+}
+
+void b2TraceRecord(const char* name, uint64 begin, uint64 end)
+{
+	b2TraceBuffer* buffer = b2GetTraceBuffer();
+	uint64 count = buffer->count.load(std::memory_order_relaxed);
+	b2TraceEvent* event = buffer->events + (count & (b2_traceCapacity - 1));
+	event->name = name;
+	event->begin = begin;
+	event->end = end;
+	buffer->count.store(count + 1, std::memory_order_release);
+}
+
+void b2TraceSetThreadName(const char* name)
+{
+	b2TraceBuffer* buffer = b2GetTraceBuffer();
+	strncpy(buffer->threadName, name, sizeof(buffer->threadName) - 1);
+	buffer->threadName[sizeof(buffer->threadName) - 1] = 0;
+}
+
+// Zone names are string literals, only quotes and backslashes need escaping.
+static void b2WriteTraceString(FILE* file, const char* s)
+{
+	fputc('"', file);
+	for (; *s; ++s)
+	{
+		if (*s == '"' || *s == '\\')
+		{
+			fputc('\\', file);
+		}
+		fputc(*s, file);
+	}
+	fputc('"', file);
+}
+
+bool b2TraceExport(const char* path)
+{
+	FILE* file = fopen(path, "w");
+	if (file == NULL)
+	{
+		return false;
+	}
+
+	// Chrome traces are in microseconds. Times are relative to the earliest
+	// event still held in a buffer.
+	float64 toMicroseconds = b2Timer::GetTickPeriod() * 1.0e-3;
+	uint64 origin = ~0ull;
+	for (b2TraceBuffer* buffer = s_traceBuffers.load(); buffer; buffer = buffer->next)
+	{
+		uint64 count = buffer->count.load(std::memory_order_acquire);
+		uint64 first = count > b2_traceCapacity ? count - b2_traceCapacity : 0;
+		for (uint64 i = first; i < count; ++i)
+		{
+			origin = b2Min(origin, buffer->events[i & (b2_traceCapacity - 1)].begin);
+		}
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+	bool comma = false;
+	for (b2TraceBuffer* buffer = s_traceBuffers.load(); buffer; buffer = buffer->next)
+	{
+		if (buffer->threadName[0])
+		{
+			fprintf(file, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+					comma ? ",\n" : "", buffer->threadId);
+			b2WriteTraceString(file, buffer->threadName);
+			fprintf(file, "}}");
+			comma = true;
+		}
+
+		uint64 count = buffer->count.load(std::memory_order_acquire);
+		uint64 first = count > b2_traceCapacity ? count - b2_traceCapacity : 0;
+		for (uint64 i = first; i < count; ++i)
+		{
+			const b2TraceEvent* event = buffer->events + (i & (b2_traceCapacity - 1));
+			fprintf(file, "%s{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+					comma ? ",\n" : "", buffer->threadId,
+					float64(event->begin - origin) * toMicroseconds,
+					float64(event->end - event->begin) * toMicroseconds);
+			b2WriteTraceString(file, event->name);
+			fputc('}', file);
+			comma = true;
+		}
+	}
+	fprintf(file, "\n]}\n");
+
+	bool ok = ferror(file) == 0;
+	ok = fclose(file) == 0 && ok;
+	return ok;
+}
+
+static void b2TraceExit()
+{
+	b2TraceExport(s_traceExitPath);
+}
+
+void b2TraceExportOnExit(const char* path)
+{
+	bool registered = s_traceExitPath[0] != 0;
+	strncpy(s_traceExitPath, path, sizeof(s_traceExitPath) - 1);
+	if (registered == false)
+	{
+		atexit(b2TraceExit);
+	}
+}
+
+#else
+
+void b2TraceSetThreadName(const char* name)
+{
+	B2_NOT_USED(name);
+}
+
+bool b2TraceExport(const char* path)
+{
+	B2_NOT_USED(path);
+	return false;
+}
+
+void b2TraceExportOnExit(const char* path)
+{
+	B2_NOT_USED(path);
+}
+
+#endif
@@ -0,0 +1,81 @@
+/*
+* Copyright (c) 2011 Erin Catto http://box2d.org
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TRACE_H
+#define B2_TRACE_H
+
+#include <Box2D/Common/b2Timer.h>
+
+/// Timeline tracing. Define B2_TRACE (requires C++11) for the library and
+/// for any code using b2TraceZone. Each thread records the zones it closes
+/// into its own ring buffer of b2_traceCapacity events without locking;
+/// older events are overwritten. b2TraceExport writes all buffers as Chrome
+/// trace JSON for chrome://tracing or Perfetto. Without B2_TRACE the zones
+/// compile to nothing and the functions below do nothing.
+
+/// Events kept per thread. Must be a power of two.
+#define b2_traceCapacity	(1 << 16)
+
+#if defined(B2_TRACE)
+
+/// Record a zone that started and ended at the given b2Timer::GetTicks values.
+/// The name must stay valid until the trace is exported, use string literals.
+void b2TraceRecord(const char* name, uint64 begin, uint64 end);
+
+/// Records the lifetime of the scope as a zone. Use b2TraceZone.
+class b2TraceScope
+{
+public:
+	explicit b2TraceScope(const char* name)
+	{
+		m_name = name;
+		m_begin = b2Timer::GetTicks();
+	}
+
+	~b2TraceScope()
+	{
+		b2TraceRecord(m_name, m_begin, b2Timer::GetTicks());
+	}
+
+private:
+	const char* m_name;
+	uint64 m_begin;
+};
+
+#define B2_TRACE_CONCAT_INNER(a, b) a##b
+#define B2_TRACE_CONCAT(a, b) B2_TRACE_CONCAT_INNER(a, b)
+#define b2TraceZone(name) b2TraceScope B2_TRACE_CONCAT(b2_traceZone, __LINE__)(name)
+
+#else
+
+#define b2TraceZone(name)
+
+#endif
+
+/// Name the calling thread in exported traces. The name is copied.
+void b2TraceSetThreadName(const char* name);
+
+/// Write the events of all threads to a Chrome trace JSON file. Threads
+/// should be idle, zones that close during the export may be torn.
+/// @return false if the file cannot be written or tracing is compiled out.
+bool b2TraceExport(const char* path);
+
+/// Export to the given file when the process exits normally.
+void b2TraceExportOnExit(const char* path);
+
+#endif
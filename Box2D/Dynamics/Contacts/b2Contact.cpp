@@ -31,6 +31,7 @@
 #include <Box2D/Collision/Shapes/b2Shape.h>
 #include <Box2D/Common/b2BlockAllocator.h>
 #include <Box2D/Dynamics/b2Body.h>
+#include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2Fixture.h>
 #include <Box2D/Dynamics/b2World.h>
 
@@ -134,6 +135,7 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 	m_indexB = indexB;
 
 	m_manifold.pointCount = 0;
+	m_manifoldXf.SetIdentity();
 
 	m_prev = NULL;
 	m_next = NULL;
@@ -158,8 +160,9 @@ b2Contact::b2Contact(b2Fixture* fA, int32 indexA, b2Fixture* fB, int32 indexB)
 
 // Update the contact manifold and touching status.
 // Note: do not assume the fixture AABBs are overlapping or are valid.
-void b2Contact::Update(b2ContactListener* listener)
+void b2Contact::Update(b2ContactManager* contactManager)
 {
+	b2ContactListener* listener = contactManager->m_contactListener;
 	b2Manifold oldManifold = m_manifold;
 
 	// Re-enable this contact.
@@ -189,9 +192,39 @@ void b2Contact::Update(b2ContactListener* listener)
 	}
 	else
 	{
+		// The manifold is stored in local coordinates, so it stays valid as long as
+		// the bodies keep their relative transform. Reuse it, impulses and feature
+		// ids included, while that transform is within the world's tolerance.
+		b2Transform xf = b2MulT(xfA, xfB);
+		float32 linearTolerance = contactManager->m_manifoldLinearTolerance;
+		float32 angularTolerance = contactManager->m_manifoldAngularTolerance;
+
+		bool reuse = false;
+		if ((m_flags & e_manifoldXfFlag) && linearTolerance > 0.0f)
+		{
+			b2Rot dq = b2MulT(m_manifoldXf.q, xf.q);
+			reuse = b2DistanceSquared(xf.p, m_manifoldXf.p) <= linearTolerance * linearTolerance &&
+					dq.c > 0.0f && b2Abs(dq.s) <= angularTolerance;
+		}
+
+		if (reuse)
+		{
+			++contactManager->m_manifoldReuseCount;
+			touching = wasTouching;
+			if (touching && listener)
+			{
+				listener->PreSolve(this, &oldManifold);
+			}
+			return;
+		}
+
+		++contactManager->m_manifoldEvaluateCount;
 		Evaluate(&m_manifold, xfA, xfB);
 		touching = m_manifold.pointCount > 0;
 
+		m_manifoldXf = xf;
+		m_flags |= e_manifoldXfFlag;
+
 		// Match old contact ids to new contact ids and copy the
 		// stored impulses to warm start the solver.
 		for (int32 i = 0; i < m_manifold.pointCount; ++i)
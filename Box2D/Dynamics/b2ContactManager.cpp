@@ -19,6 +19,7 @@
 #include <Box2D/Dynamics/b2ContactManager.h>
 #include <Box2D/Dynamics/b2Body.h>
 #include <Box2D/Dynamics/b2Fixture.h>
+#include <Box2D/Dynamics/b2TimeStep.h>
 #include <Box2D/Dynamics/b2WorldCallbacks.h>
 #include <Box2D/Dynamics/Contacts/b2Contact.h>
 
@@ -32,6 +33,11 @@ b2ContactManager::b2ContactManager()
 	m_contactFilter = &b2_defaultFilter;
 	m_contactListener = &b2_defaultListener;
 	m_allocator = NULL;
+	m_profile = NULL;
+	m_manifoldLinearTolerance = 0.0f;
+	m_manifoldAngularTolerance = 0.0f;
+	m_manifoldReuseCount = 0;
+	m_manifoldEvaluateCount = 0;
 }
 
 void b2ContactManager::Destroy(b2Contact* c)
@@ -97,6 +103,7 @@ void b2ContactManager::Destroy(b2Contact* c)
 	// Call the factory.
 	b2Contact::Destroy(c, m_allocator);
 	--m_contactCount;
+	b2ProfileCount(m_profile->contactsDestroyed, 1);
 }
 
 // This is the top level collision call for the time step. Here
@@ -146,6 +153,7 @@ void b2ContactManager::Collide()
 		// At least one body must be awake and it must be dynamic or kinematic.
 		if (activeA == false && activeB == false)
 		{
+			b2ProfileCount(m_profile->touchingContacts, c->IsTouching() ? 1 : 0);
 			c = c->GetNext();
 			continue;
 		}
@@ -164,7 +172,8 @@ void b2ContactManager::Collide()
 		}
 
 		// The contact persists.
-		c->Update(m_contactListener);
+		c->Update(this);
+		b2ProfileCount(m_profile->touchingContacts, c->IsTouching() ? 1 : 0);
 		c = c->GetNext();
 	}
 }
@@ -179,6 +188,8 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	b2FixtureProxy* proxyA = (b2FixtureProxy*)proxyUserDataA;
 	b2FixtureProxy* proxyB = (b2FixtureProxy*)proxyUserDataB;
 
+	b2ProfileCount(m_profile->pairsFound, 1);
+
 	b2Fixture* fixtureA = proxyA->fixture;
 	b2Fixture* fixtureB = proxyB->fixture;
 
@@ -285,6 +296,8 @@ void b2ContactManager::AddPair(void* proxyUserDataA, void* proxyUserDataB)
 	}
 	bodyB->m_contactList = &c->m_nodeB;
 
+	b2ProfileCount(m_profile->contactsCreated, 1);
+
 	// Wake up the bodies
 	if (fixtureA->IsSensor() == false && fixtureB->IsSensor() == false)
 	{
@@ -25,6 +25,7 @@ class b2Contact;
 class b2ContactFilter;
 class b2ContactListener;
 class b2BlockAllocator;
+struct b2Profile;
 
 // Delegate of b2World.
 class b2ContactManager
@@ -47,6 +48,15 @@ public:
 	b2ContactFilter* m_contactFilter;
 	b2ContactListener* m_contactListener;
 	b2BlockAllocator* m_allocator;
+
+	// Step counters are written here, see b2Profile.
+	b2Profile* m_profile;
+
+	// Manifold reuse, see b2World::SetManifoldReuseTolerance.
+	float32 m_manifoldLinearTolerance;
+	float32 m_manifoldAngularTolerance;
+	int32 m_manifoldReuseCount;
+	int32 m_manifoldEvaluateCount;
 };
 
 #endif
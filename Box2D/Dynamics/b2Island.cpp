@@ -26,6 +26,7 @@
 #include <Box2D/Dynamics/Joints/b2Joint.h>
 #include <Box2D/Common/b2StackAllocator.h>
 #include <Box2D/Common/b2Timer.h>
+#include <Box2D/Common/b2Trace.h>
 
 /*
 Position Correction Notes
@@ -180,9 +181,12 @@ b2Island::~b2Island()
 	m_allocator->Free(m_bodies);
 }
 
-void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep)
+void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep,
+					  const b2PerfCounters* perfCounters)
 {
+	b2TraceZone("b2Island::Solve");
 	b2Timer timer;
+	b2HardwareCounters counters;
 
 	float32 h = step.dt;
 
@@ -224,6 +228,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	}
 
 	timer.Reset();
+	perfCounters->Read(&counters);
 
 	// Solver data
 	b2SolverData solverData;
@@ -254,6 +259,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	}
 
 	profile->solveInit = timer.GetMilliseconds();
+	perfCounters->ReadDelta(&profile->solveInitCounters, &counters);
 
 	// Solve velocity constraints
 	timer.Reset();
@@ -270,6 +276,8 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	// Store impulses for warm starting
 	contactSolver.StoreImpulses();
 	profile->solveVelocity = timer.GetMilliseconds();
+	perfCounters->ReadDelta(&profile->solveVelocityCounters, &counters);
+	profile->velocityIterations = step.velocityIterations;
 
 	// Integrate positions
 	for (int32 i = 0; i < m_bodyCount; ++i)
@@ -306,9 +314,13 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 
 	// Solve position constraints
 	timer.Reset();
+	perfCounters->Read(&counters);
 	bool positionSolved = false;
+	profile->positionIterations = 0;
 	for (int32 i = 0; i < step.positionIterations; ++i)
 	{
+		b2ProfileCount(profile->positionIterations, 1);
+
 		bool contactsOkay = contactSolver.SolvePositionConstraints();
 
 		bool jointsOkay = true;
@@ -338,6 +350,7 @@ void b2Island::Solve(b2Profile* profile, const b2TimeStep& step, const b2Vec2& g
 	}
 
 	profile->solvePosition = timer.GetMilliseconds();
+	perfCounters->ReadDelta(&profile->solvePositionCounters, &counters);
 
 	Report(contactSolver.m_velocityConstraints);
 
@@ -20,11 +20,16 @@
 #define B2_TIME_STEP_H
 
 #include <Box2D/Common/b2Math.h>
+#include <Box2D/Common/b2PerfCounters.h>
 
-/// Profiling data. Times are in milliseconds.
+/// Profiling data. Times are in milliseconds with sub-microsecond resolution,
+/// phases that did not run in the last step report zero. The counters are for
+/// the last step, including changes made to the world since the step before,
+/// and stay zero when B2_NO_PROFILE_COUNTERS is defined.
 struct b2Profile
 {
 	float32 step;
+	float32 stepCpu;	///< CPU time of the stepping thread, below step when it was preempted
 	float32 collide;
 	float32 solve;
 	float32 solveInit;
@@ -32,6 +37,52 @@ struct b2Profile
 	float32 solvePosition;
 	float32 broadphase;
 	float32 solveTOI;
+
+	/// Hardware counters of the timed phases, see b2World::SetHardwareCounters.
+	b2HardwareCounters collideCounters;
+	b2HardwareCounters solveCounters;	///< building and solving the islands, broadphase excluded
+	b2HardwareCounters solveInitCounters;	///< summed over all islands
+	b2HardwareCounters solveVelocityCounters;	///< summed over all islands
+	b2HardwareCounters solvePositionCounters;	///< summed over all islands
+	b2HardwareCounters broadphaseCounters;
+	b2HardwareCounters solveTOICounters;
+
+	int32 pairsFound;			///< pairs reported by the broad-phase
+	int32 contactsCreated;
+	int32 contactsDestroyed;
+	int32 touchingContacts;		///< contacts touching after the collide phase
+	int32 islandCount;
+	int32 islandSizes[b2_profileIslandBuckets];	///< island count by body count, see b2_profileIslandBuckets
+	int32 largestIsland;		///< body count of the largest island
+	int32 velocityIterations;	///< summed over all islands
+	int32 positionIterations;	///< summed over all islands, includes early exits
+	int32 toiEvents;			///< time of impact computations
+	int32 toiSubSteps;			///< sub-steps solved by the TOI phase
+	int32 treeRotations;		///< broad-phase tree rotations
+	int32 proxyMoves;			///< proxies re-inserted into the broad-phase tree
+};
+
+/// Rolling statistics of one b2Profile timer, in milliseconds.
+struct b2ProfileTimerStats
+{
+	float32 min;
+	float32 avg;
+	float32 p99;
+};
+
+/// Rolling statistics of the b2Profile timers over the last steps.
+/// See b2World::GetProfileStats.
+struct b2ProfileStats
+{
+	int32 stepCount;	///< number of steps in the window
+	b2ProfileTimerStats step;
+	b2ProfileTimerStats collide;
+	b2ProfileTimerStats solve;
+	b2ProfileTimerStats solveInit;
+	b2ProfileTimerStats solveVelocity;
+	b2ProfileTimerStats solvePosition;
+	b2ProfileTimerStats broadphase;
+	b2ProfileTimerStats solveTOI;
 };
 
 /// This is an internal structure.
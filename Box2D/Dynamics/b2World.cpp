@@ -32,8 +32,47 @@
 #include <Box2D/Collision/b2TimeOfImpact.h>
 #include <Box2D/Common/b2Draw.h>
 #include <Box2D/Common/b2Timer.h>
+#include <Box2D/Common/b2Trace.h>
+#include <algorithm>
 #include <new>
 
+// The timers of one step that GetProfileStats reports.
+struct b2ProfileTimers
+{
+	float32 step;
+	float32 collide;
+	float32 solve;
+	float32 solveInit;
+	float32 solveVelocity;
+	float32 solvePosition;
+	float32 broadphase;
+	float32 solveTOI;
+};
+
+// A ring buffer of the timers of the last b2_profileWindow steps. Only the
+// timers are kept, a whole b2Profile would copy the counters as well.
+struct b2ProfileHistory
+{
+	void Add(const b2Profile& profile)
+	{
+		b2ProfileTimers* timers = steps + index;
+		timers->step = profile.step;
+		timers->collide = profile.collide;
+		timers->solve = profile.solve;
+		timers->solveInit = profile.solveInit;
+		timers->solveVelocity = profile.solveVelocity;
+		timers->solvePosition = profile.solvePosition;
+		timers->broadphase = profile.broadphase;
+		timers->solveTOI = profile.solveTOI;
+		index = (index + 1) % b2_profileWindow;
+		count = b2Min(count + 1, b2_profileWindow);
+	}
+
+	b2ProfileTimers steps[b2_profileWindow];
+	int32 index;
+	int32 count;
+};
+
 b2World::b2World(const b2Vec2& gravity)
 {
 	m_destructionListener = NULL;
@@ -59,8 +98,14 @@ b2World::b2World(const b2Vec2& gravity)
 	m_inv_dt0 = 0.0f;
 
 	m_contactManager.m_allocator = &m_blockAllocator;
+	m_contactManager.m_profile = &m_profile;
 
 	memset(&m_profile, 0, sizeof(b2Profile));
+	memset(&m_lastProfile, 0, sizeof(b2Profile));
+	m_openPerfCounters = false;
+	m_closePerfCounters = false;
+
+	m_profileHistory = NULL;
 }
 
 b2World::~b2World()
@@ -82,6 +127,8 @@ b2World::~b2World()
 
 		b = bNext;
 	}
+
+	SetProfileStats(false);
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -128,6 +175,116 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	return b;
 }
 
+void b2World::CreateBodies(const b2BodyDef* bodyDefs, int32 bodyCount,
+						   const b2FixtureDef* fixtureDefs, const int32* fixtureCounts,
+						   b2Body** bodies)
+{
+	b2Assert(IsLocked() == false);
+	if (IsLocked() || bodyCount <= 0)
+	{
+		return;
+	}
+
+	b2BroadPhase* broadPhase = &m_contactManager.m_broadPhase;
+
+	// Count the broad-phase proxies so they can be inserted in one batch.
+	int32 proxyCount = 0;
+	int32 fixtureIndex = 0;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		int32 fixtureCount = fixtureCounts ? fixtureCounts[i] : 1;
+		if (bodyDefs[i].active)
+		{
+			for (int32 j = 0; j < fixtureCount; ++j)
+			{
+				proxyCount += fixtureDefs[fixtureIndex + j].shape->GetChildCount();
+			}
+		}
+		fixtureIndex += fixtureCount;
+	}
+
+	b2AABB* aabbs = NULL;
+	void** userData = NULL;
+	int32* proxyIds = NULL;
+	b2FixtureProxy** proxies = NULL;
+	if (proxyCount > 0)
+	{
+		aabbs = (b2AABB*)b2Alloc(proxyCount * sizeof(b2AABB));
+		userData = (void**)b2Alloc(proxyCount * sizeof(void*));
+		proxyIds = (int32*)b2Alloc(proxyCount * sizeof(int32));
+		proxies = (b2FixtureProxy**)b2Alloc(proxyCount * sizeof(b2FixtureProxy*));
+	}
+
+	int32 proxyIndex = 0;
+	fixtureIndex = 0;
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		b2Body* b = CreateBody(bodyDefs + i);
+		if (bodies)
+		{
+			bodies[i] = b;
+		}
+
+		bool hasMass = false;
+		int32 fixtureCount = fixtureCounts ? fixtureCounts[i] : 1;
+		for (int32 j = 0; j < fixtureCount; ++j)
+		{
+			void* memory = m_blockAllocator.Allocate(sizeof(b2Fixture));
+			b2Fixture* fixture = new (memory) b2Fixture;
+			fixture->Create(&m_blockAllocator, b, fixtureDefs + fixtureIndex + j);
+
+			// Same as b2Fixture::CreateProxies, minus the tree insertion.
+			if (b->m_flags & b2Body::e_activeFlag)
+			{
+				fixture->m_proxyCount = fixture->m_shape->GetChildCount();
+				for (int32 k = 0; k < fixture->m_proxyCount; ++k)
+				{
+					b2FixtureProxy* proxy = fixture->m_proxies + k;
+					fixture->m_shape->ComputeAABB(&proxy->aabb, b->m_xf, k);
+					proxy->fixture = fixture;
+					proxy->childIndex = k;
+
+					aabbs[proxyIndex] = proxy->aabb;
+					userData[proxyIndex] = proxy;
+					proxies[proxyIndex] = proxy;
+					++proxyIndex;
+				}
+			}
+
+			fixture->m_next = b->m_fixtureList;
+			b->m_fixtureList = fixture;
+			++b->m_fixtureCount;
+
+			hasMass = hasMass || fixture->m_density > 0.0f;
+		}
+		fixtureIndex += fixtureCount;
+
+		// Adjust mass properties once for all fixtures.
+		if (hasMass)
+		{
+			b->ResetMassData();
+		}
+	}
+
+	b2Assert(proxyIndex == proxyCount);
+	if (proxyCount > 0)
+	{
+		broadPhase->CreateProxies(aabbs, userData, proxyCount, proxyIds);
+		for (int32 i = 0; i < proxyCount; ++i)
+		{
+			proxies[i]->proxyId = proxyIds[i];
+		}
+
+		b2Free(proxies);
+		b2Free(proxyIds);
+		b2Free(userData);
+		b2Free(aabbs);
+	}
+
+	// New contacts are created at the beginning of the next time step.
+	m_flags |= e_newFixture;
+}
+
 void b2World::DestroyBody(b2Body* b)
 {
 	b2Assert(m_bodyCount > 0);
@@ -389,6 +546,11 @@ void b2World::Solve(const b2TimeStep& step)
 	m_profile.solveVelocity = 0.0f;
 	m_profile.solvePosition = 0.0f;
 
+	// The islands read the counters around each of their phases and the deltas
+	// are summed here. The total is read once around all islands.
+	b2HardwareCounters islandCounters;
+	m_perfCounters.Read(&islandCounters);
+
 	// Size the island for the worst case.
 	b2Island island(m_bodyCount,
 					m_contactManager.m_contactCount,
@@ -528,10 +690,27 @@ void b2World::Solve(const b2TimeStep& step)
 		}
 
 		b2Profile profile;
-		island.Solve(&profile, step, m_gravity, m_allowSleep);
+		island.Solve(&profile, step, m_gravity, m_allowSleep, &m_perfCounters);
 		m_profile.solveInit += profile.solveInit;
 		m_profile.solveVelocity += profile.solveVelocity;
 		m_profile.solvePosition += profile.solvePosition;
+		b2AddCounters(&m_profile.solveInitCounters, profile.solveInitCounters);
+		b2AddCounters(&m_profile.solveVelocityCounters, profile.solveVelocityCounters);
+		b2AddCounters(&m_profile.solvePositionCounters, profile.solvePositionCounters);
+
+#if defined(B2_PROFILE_COUNTERS)
+		int32 bucket = 0;
+		for (int32 n = island.m_bodyCount; n > 1 && bucket < b2_profileIslandBuckets - 1; n >>= 1)
+		{
+			++bucket;
+		}
+
+		++m_profile.islandCount;
+		++m_profile.islandSizes[bucket];
+		m_profile.largestIsland = b2Max(m_profile.largestIsland, island.m_bodyCount);
+		m_profile.velocityIterations += profile.velocityIterations;
+		m_profile.positionIterations += profile.positionIterations;
+#endif
 
 		// Post solve cleanup.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -546,9 +725,13 @@ void b2World::Solve(const b2TimeStep& step)
 	}
 
 	m_stackAllocator.Free(stack);
+	m_perfCounters.ReadDelta(&m_profile.solveCounters, &islandCounters);
 
 	{
+		b2TraceZone("Broadphase");
 		b2Timer timer;
+		b2HardwareCounters counters;
+		m_perfCounters.Read(&counters);
 		// Synchronize fixtures, check for out of range bodies.
 		for (b2Body* b = m_bodyList; b; b = b->GetNext())
 		{
@@ -570,6 +753,7 @@ void b2World::Solve(const b2TimeStep& step)
 		// Look for new contacts.
 		m_contactManager.FindNewContacts();
 		m_profile.broadphase = timer.GetMilliseconds();
+		m_perfCounters.ReadDelta(&m_profile.broadphaseCounters, &counters);
 	}
 }
 
@@ -688,6 +872,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 				b2TOIOutput output;
 				b2TimeOfImpact(&output, &input);
+				b2ProfileCount(m_profile.toiEvents, 1);
 
 				// Beta is the fraction of the remaining portion of the .
 				float32 beta = output.t;
@@ -732,7 +917,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		bB->Advance(minAlpha);
 
 		// The TOI contact likely has some new contact points.
-		minContact->Update(m_contactManager.m_contactListener);
+		minContact->Update(&m_contactManager);
 		minContact->m_flags &= ~b2Contact::e_toiFlag;
 		++minContact->m_toiCount;
 
@@ -812,7 +997,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 					}
 
 					// Update the contact points
-					contact->Update(m_contactManager.m_contactListener);
+					contact->Update(&m_contactManager);
 
 					// Was the contact disabled by the user?
 					if (contact->IsEnabled() == false)
@@ -861,6 +1046,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.warmStarting = false;
 		island.SolveTOI(subStep, bA->m_islandIndex, bB->m_islandIndex);
+		b2ProfileCount(m_profile.toiSubSteps, 1);
 
 		// Reset island flags and synchronize broad-phase proxies.
 		for (int32 i = 0; i < island.m_bodyCount; ++i)
@@ -896,7 +1082,25 @@ void b2World::SolveTOI(const b2TimeStep& step)
 
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations)
 {
+	b2TraceZone("b2World::Step");
 	b2Timer stepTimer;
+	b2CpuTimer stepCpuTimer;
+
+	m_contactManager.m_manifoldReuseCount = 0;
+	m_contactManager.m_manifoldEvaluateCount = 0;
+
+	// Open and close the hardware counters on the stepping thread. Only try once.
+	if (m_closePerfCounters)
+	{
+		m_perfCounters.Close();
+		m_closePerfCounters = false;
+	}
+	if (m_openPerfCounters)
+	{
+		m_perfCounters.Open();
+		m_openPerfCounters = false;
+	}
+	b2HardwareCounters counters;
 
 	// If new fixtures were added, we need to find the new contacts.
 	if (m_flags & e_newFixture)
@@ -926,14 +1130,18 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	
 	// Update contacts. This is where some contacts are destroyed.
 	{
+		b2TraceZone("Collide");
 		b2Timer timer;
+		m_perfCounters.Read(&counters);
 		m_contactManager.Collide();
 		m_profile.collide = timer.GetMilliseconds();
+		m_perfCounters.ReadDelta(&m_profile.collideCounters, &counters);
 	}
 
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (m_stepComplete && step.dt > 0.0f)
 	{
+		b2TraceZone("Solve");
 		b2Timer timer;
 		Solve(step);
 		m_profile.solve = timer.GetMilliseconds();
@@ -942,9 +1150,12 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	// Handle TOI events.
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
+		b2TraceZone("SolveTOI");
 		b2Timer timer;
+		m_perfCounters.Read(&counters);
 		SolveTOI(step);
 		m_profile.solveTOI = timer.GetMilliseconds();
+		m_perfCounters.ReadDelta(&m_profile.solveTOICounters, &counters);
 	}
 
 	if (step.dt > 0.0f)
@@ -960,6 +1171,94 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	m_flags &= ~e_locked;
 
 	m_profile.step = stepTimer.GetMilliseconds();
+	m_profile.stepCpu = stepCpuTimer.GetMilliseconds();
+
+#if defined(B2_PROFILE_COUNTERS)
+	m_profile.treeRotations = m_contactManager.m_broadPhase.GetTreeRotationCount();
+	m_profile.proxyMoves = m_contactManager.m_broadPhase.GetTreeReinsertCount();
+
+	if (m_profileHistory)
+	{
+		m_profileHistory->Add(m_profile);
+	}
+#endif
+
+	// Publish the step and start collecting for the next one here rather than
+	// at the start of Step, so counts from between the steps are kept.
+	// Phases the next step skips report zero.
+	m_lastProfile = m_profile;
+	memset(&m_profile, 0, sizeof(b2Profile));
+#if defined(B2_PROFILE_COUNTERS)
+	m_contactManager.m_broadPhase.ResetTreeCounters();
+#endif
+}
+
+void b2World::SetProfileStats(bool flag)
+{
+	b2Assert(IsLocked() == false);
+#if defined(B2_PROFILE_COUNTERS)
+	if (flag && m_profileHistory == NULL)
+	{
+		void* mem = b2Alloc(sizeof(b2ProfileHistory));
+		m_profileHistory = new (mem) b2ProfileHistory;
+		m_profileHistory->index = 0;
+		m_profileHistory->count = 0;
+	}
+	else if (flag == false && m_profileHistory)
+	{
+		m_profileHistory->~b2ProfileHistory();
+		b2Free(m_profileHistory);
+		m_profileHistory = NULL;
+	}
+#else
+	B2_NOT_USED(flag);
+#endif
+}
+
+#if defined(B2_PROFILE_COUNTERS)
+// Min, average and nearest-rank 99th percentile of one timer over the history.
+static void b2ComputeTimerStats(b2ProfileTimerStats* stats, const b2ProfileHistory* history,
+								float32 b2ProfileTimers::*timer)
+{
+	int32 count = history->count;
+	float32 samples[b2_profileWindow];
+	float32 sum = 0.0f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		samples[i] = history->steps[i].*timer;
+		sum += samples[i];
+	}
+
+	std::sort(samples, samples + count);
+
+	int32 rank = (99 * count + 99) / 100;
+	stats->min = samples[0];
+	stats->avg = sum / count;
+	stats->p99 = samples[rank - 1];
+}
+#endif
+
+void b2World::GetProfileStats(b2ProfileStats* stats) const
+{
+	memset(stats, 0, sizeof(b2ProfileStats));
+
+#if defined(B2_PROFILE_COUNTERS)
+	if (m_profileHistory == NULL || m_profileHistory->count == 0)
+	{
+		return;
+	}
+
+	const b2ProfileHistory* history = m_profileHistory;
+	stats->stepCount = history->count;
+	b2ComputeTimerStats(&stats->step, history, &b2ProfileTimers::step);
+	b2ComputeTimerStats(&stats->collide, history, &b2ProfileTimers::collide);
+	b2ComputeTimerStats(&stats->solve, history, &b2ProfileTimers::solve);
+	b2ComputeTimerStats(&stats->solveInit, history, &b2ProfileTimers::solveInit);
+	b2ComputeTimerStats(&stats->solveVelocity, history, &b2ProfileTimers::solveVelocity);
+	b2ComputeTimerStats(&stats->solvePosition, history, &b2ProfileTimers::solvePosition);
+	b2ComputeTimerStats(&stats->broadphase, history, &b2ProfileTimers::broadphase);
+	b2ComputeTimerStats(&stats->solveTOI, history, &b2ProfileTimers::solveTOI);
+#endif
 }
 
 void b2World::ClearForces()
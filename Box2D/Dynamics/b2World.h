@@ -29,7 +29,9 @@
 struct b2AABB;
 struct b2BodyDef;
 struct b2Color;
+struct b2ProfileHistory;
 struct b2JointDef;
+struct b2FixtureDef;
 class b2Body;
 class b2Draw;
 class b2Fixture;
@@ -71,6 +73,19 @@ public:
 	/// @warning This function is locked during callbacks.
 	b2Body* CreateBody(const b2BodyDef* def);
 
+	/// Create many rigid bodies with their fixtures in one call. Mass data is
+	/// computed once per body and all broad-phase proxies are inserted together,
+	/// which is much faster than CreateBody/CreateFixture for large batches.
+	/// No reference to the definitions is retained.
+	/// @param bodyDefs array of bodyCount body definitions.
+	/// @param fixtureDefs fixture definitions of all bodies, stored consecutively.
+	/// @param fixtureCounts number of fixtures of each body, or NULL for exactly one fixture per body.
+	/// @param bodies optional array of bodyCount that receives the new bodies.
+	/// @warning This function is locked during callbacks.
+	void CreateBodies(const b2BodyDef* bodyDefs, int32 bodyCount,
+					  const b2FixtureDef* fixtureDefs, const int32* fixtureCounts,
+					  b2Body** bodies);
+
 	/// Destroy a rigid body given a definition. No reference to the definition
 	/// is retained. This function is locked during callbacks.
 	/// @warning This automatically deletes all associated shapes and joints.
@@ -157,6 +172,20 @@ public:
 	void SetSubStepping(bool flag) { m_subStepping = flag; }
 	bool GetSubStepping() const { return m_subStepping; }
 
+	/// Reuse contact manifolds across steps. While the transform of one body relative
+	/// to the other stays within these tolerances of the transform the manifold was
+	/// computed at, the narrow phase is skipped and the manifold is carried forward.
+	/// Zero disables reuse, which is the default.
+	/// @param linearTolerance relative translation tolerance in meters.
+	/// @param angularTolerance relative rotation tolerance in radians.
+	void SetManifoldReuseTolerance(float32 linearTolerance, float32 angularTolerance);
+
+	/// Get the number of contact updates that reused their manifold in the last step.
+	int32 GetManifoldReuseCount() const;
+
+	/// Get the number of contact updates that ran the narrow phase in the last step.
+	int32 GetManifoldEvaluateCount() const;
+
 	/// Get the number of broad-phase proxies.
 	int32 GetProxyCount() const;
 
@@ -205,6 +234,31 @@ public:
 	/// Get the current profile.
 	const b2Profile& GetProfile() const;
 
+	/// Keep the profile timers of the last b2_profileWindow steps for
+	/// GetProfileStats. Off by default: the history is allocated when this is
+	/// turned on and freed when it is turned off, which also clears it. Does
+	/// nothing when B2_NO_PROFILE_COUNTERS is defined.
+	/// @warning this should be called outside of a time step.
+	void SetProfileStats(bool flag);
+
+	/// Get the min, average and 99th percentile of each profile timer over the
+	/// last b2_profileWindow steps. All zero unless SetProfileStats turned the
+	/// history on.
+	void GetProfileStats(b2ProfileStats* stats) const;
+
+	/// Attribute hardware performance counters to the phases of b2Profile: collide,
+	/// solve (the islands as a whole), its solveInit, solveVelocity and solvePosition
+	/// parts summed over the islands, broadphase and solveTOI. The island parts cost a
+	/// few counter reads per island, which shows in steps with many small islands.
+	/// The counters are opened or closed by the next Step and follow the thread calling it.
+	/// Where they are unavailable the profile counters stay zero, see b2PerfCounters.
+	void SetHardwareCounters(bool flag);
+
+	/// Are hardware counters being gathered? False until the first step after
+	/// enabling them, and if they could not be opened. True until the first step
+	/// after disabling them.
+	bool GetHardwareCounters() const;
+
 	/// Dump the world into the log file.
 	/// @warning this should be called outside of a time step.
 	void Dump();
@@ -260,7 +314,20 @@ private:
 
 	bool m_stepComplete;
 
+	// Collected for the next step, including counts of changes made between
+	// steps, such as the contacts DestroyBody destroys. Step publishes it to
+	// m_lastProfile and clears it when it ends.
 	b2Profile m_profile;
+	b2Profile m_lastProfile;
+
+	b2PerfCounters m_perfCounters;
+	bool m_openPerfCounters;
+	bool m_closePerfCounters;
+
+	// The timers of the last steps for GetProfileStats, NULL until
+	// SetProfileStats asks for them. A pointer keeps the layout of b2World
+	// the same with and without B2_NO_PROFILE_COUNTERS.
+	b2ProfileHistory* m_profileHistory;
 };
 
 inline b2Body* b2World::GetBodyList()
@@ -308,6 +375,22 @@ inline int32 b2World::GetContactCount() const
 	return m_contactManager.m_contactCount;
 }
 
+inline void b2World::SetManifoldReuseTolerance(float32 linearTolerance, float32 angularTolerance)
+{
+	m_contactManager.m_manifoldLinearTolerance = linearTolerance;
+	m_contactManager.m_manifoldAngularTolerance = angularTolerance;
+}
+
+inline int32 b2World::GetManifoldReuseCount() const
+{
+	return m_contactManager.m_manifoldReuseCount;
+}
+
+inline int32 b2World::GetManifoldEvaluateCount() const
+{
+	return m_contactManager.m_manifoldEvaluateCount;
+}
+
 inline void b2World::SetGravity(const b2Vec2& gravity)
 {
 	m_gravity = gravity;
@@ -346,9 +429,20 @@ inline const b2ContactManager& b2World::GetContactManager() const
 	return m_contactManager;
 }
 
+inline void b2World::SetHardwareCounters(bool flag)
+{
+	m_openPerfCounters = flag;
+	m_closePerfCounters = flag == false;
+}
+
+inline bool b2World::GetHardwareCounters() const
+{
+	return m_perfCounters.IsOpen();
+}
+
 inline const b2Profile& b2World::GetProfile() const
 {
-	return m_profile;
+	return m_lastProfile;
 }
 
 #endif
@@ -6,38 +6,60 @@ QMAKE_CXXFLAGS_DEBUG +=-Wall
 #QMAKE_CXXFLAGS_RELEASE -= -O2
 #QMAKE_CXXFLAGS_RELEASE += -O3 -march=native -mtune=native -fomit-frame-pointer
 
+# Timeline tracing, must match Box2D/Box2D.pro. F12 saves qbox2d-trace.json,
+# it is also written on exit.
+#DEFINES += B2_TRACE
+
 TARGET = qbox2d
 TEMPLATE = app
 
 SOURCES += main.cpp\
            mainwindow.cpp \
+           headless.cpp \
+           capture.cpp \
+           offscreenrenderer.cpp \
+           physicsthread.cpp \
            items.cpp \
-           view.cpp \
            world.cpp \
            worlds/testworld.cpp \
            worlds/exampleworld.cpp \
            worlds/arcanoidworld.cpp \
-           qscene.cpp \
            glscene.cpp \
+           glbatchrenderer.cpp \
+           glcommandbuilder.cpp \
+           glshadermanager.cpp \
+           gltextureatlas.cpp \
            physicitem.cpp \
            texture.cpp \
+           textureloader.cpp \
+           texturecache.cpp \
     contactlistener.cpp \
     brick.cpp \
     glcamera.cpp
 
 HEADERS += mainwindow.h \
+           headless.h \
+           capture.h \
+           offscreenrenderer.h \
+           physicsthread.h \
+           triplebuffer.h \
+           commandqueue.h \
            items.h \
            def.h \
-           view.h \
            world.h \
            worlds/worlds.h \
            worlds/testworld.h \
            worlds/exampleworld.h \
            worlds/arcanoidworld.h \
-           qscene.h \
            glscene.h \
+           glbatchrenderer.h \
+           glcommandbuilder.h \
+           glshadermanager.h \
+           gltextureatlas.h \
            physicitem.h \
            texture.h \
+           textureloader.h \
+           texturecache.h \
     contactlistener.h \
     brick.h \
     glcamera.h
@@ -59,4 +81,6 @@ OTHER_FILES += \
     data/shaders/texture.vsh \
     data/shaders/sqare.vsh \
     data/shaders/sqare.fsh \
-    data/shaders/texture.fsh
+    data/shaders/texture.fsh \
+    data/shaders/instanced.vsh \
+    data/shaders/instanced.fsh
@@ -4,6 +4,7 @@ Brick::Brick() :
     QBox2DItem()
 {
     _durability = 0;
+    _storedDurability = 0;
     _textures.append("kde.png");
     _textures.append("face-smile.png");
     _textures.append("exit.png");
@@ -16,6 +17,16 @@ int Brick::handleContact(){
     return _durability;
 }
 
+void Brick::storeState(){
+    QBox2DItem::storeState();
+    _storedDurability = _durability;
+}
+
+void Brick::restoreState(){
+    QBox2DItem::restoreState();
+    _durability = _storedDurability;
+}
+
 void Brick::setDurability(const int &d){
     if ( _textures.size() < d){
         setTextureName(_textures.last());
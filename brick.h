@@ -9,9 +9,12 @@ public:
     Brick();
     int handleContact();
     void setDurability(const int&);
+    void storeState();
+    void restoreState();
        
 private:
     int _durability;
+    int _storedDurability;
     QVector<QString> _textures;
 };
 
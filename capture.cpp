@@ -0,0 +1,191 @@
+#include "capture.h"
+#include "headless.h"
+#include "offscreenrenderer.h"
+#include "world.h"
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QRunnable>
+#include <QThread>
+#include <cstdio>
+
+namespace {
+
+// Encodes one frame. Pixels come bottom row first from GL.
+class PngWriter : public QRunnable
+{
+public:
+    PngWriter(const QImage &image, const QString &path, QSemaphore *slots) :
+        _image(image), _path(path), _slots(slots) {}
+
+    void run(){
+        b2TraceZone("PngWriter::run");
+        if (!_image.mirrored().save(_path, "PNG")) {
+            qWarning("Cannot write %s", qPrintable(_path));
+        }
+        _slots->release();
+    }
+
+private:
+    QImage      _image;
+    QString     _path;
+    QSemaphore* _slots;
+};
+
+}
+
+CaptureRunner::CaptureRunner(QObject *parent) :
+    QObject(parent),
+    _worldName("arcanoid"),
+    _seconds(10.0),
+    _fps(RENDER_RATE),
+    _size(1920, 1080),
+    _dir("capture"),
+    _gameFinished(false),
+    _written(0),
+    _encodeWait(0)
+{
+    // A couple of frames per worker may queue, beyond that the capture
+    // waits instead of piling up images in memory.
+    _encoders.setMaxThreadCount(QThread::idealThreadCount());
+    _encodeSlots.release(2 * _encoders.maxThreadCount());
+}
+
+CaptureRunner::~CaptureRunner()
+{
+    _encoders.waitForDone();
+}
+
+void CaptureRunner::finishGame(){
+    _gameFinished = true;
+}
+
+void CaptureRunner::write(const QImage &image){
+    QElapsedTimer wait;
+    wait.start();
+    _encodeSlots.acquire();
+    _encodeWait += wait.nsecsElapsed();
+
+    const QString path = QString("%1/frame%2.png").arg(_dir).arg(_written, 5, 10, QChar('0'));
+    _encoders.start(new PngWriter(image, path, &_encodeSlots));
+    ++_written;
+}
+
+int CaptureRunner::run(){
+    if (!QDir().mkpath(_dir)) {
+        fprintf(stderr, "Cannot create %s\n", qPrintable(_dir));
+        return 1;
+    }
+
+    OffscreenRenderer renderer;
+    if (!renderer.initialize(_size, SHADER_DIR, TEXTURE_DIR)) {
+        return 1;
+    }
+
+    QBox2DWorld *world = createWorld(_worldName, this);
+    if (!world) {
+        fprintf(stderr, "Unknown world: %s\n", qPrintable(_worldName));
+        return 1;
+    }
+    connect(world, SIGNAL(gameFinished()), this, SLOT(finishGame()));
+    world->populate();
+
+    const int frames = qMax(1, int(_seconds * _fps + 0.5));
+    const double stepsPerFrame = 1.0 / (_fps * world->timeStep());
+    const QRectF view = renderer.visibleRect();
+    WorldSnapshot snapshot;
+    qint64 steps = 0;
+    qint64 stepTime = 0;
+    qint64 renderTime = 0;
+    int games = 1;
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+    QElapsedTimer timer;
+
+    for (int frame = 0; frame < frames; ++frame) {
+        if (_gameFinished) {
+            // Replaced here, the world emitted from inside step().
+            delete world;
+            _gameFinished = false;
+            world = createWorld(_worldName, this);
+            connect(world, SIGNAL(gameFinished()), this, SLOT(finishGame()));
+            world->populate();
+            ++games;
+        }
+
+        timer.start();
+        const qint64 target = qint64(frame * stepsPerFrame + 0.5);
+        while (steps < target && !_gameFinished) {
+            world->step();
+            ++steps;
+        }
+        steps = qMax(steps, target);
+        world->snapshot(&snapshot, view);
+        stepTime += timer.nsecsElapsed();
+
+        timer.start();
+        QImage image = renderer.render(snapshot);
+        renderTime += timer.nsecsElapsed();
+        if (!image.isNull()) write(image);
+    }
+
+    timer.start();
+    for (QImage image = renderer.takePending(); !image.isNull(); image = renderer.takePending()) {
+        write(image);
+    }
+    renderTime += timer.nsecsElapsed();
+    _encoders.waitForDone();
+
+    const double wallSeconds = wallTimer.nsecsElapsed() * 1.0e-9;
+    delete world;
+
+    printf("world             %s (%d game%s)\n", qPrintable(_worldName), games, games > 1 ? "s" : "");
+    printf("frames            %d at %dx%d, %s/frame00000.png ...\n", _written,
+           _size.width(), _size.height(), qPrintable(_dir));
+    printf("wall time         %.3f s\n", wallSeconds);
+    printf("sustained         %.1f frames/s, %.2fx real time\n", _written / wallSeconds,
+           _written / _fps / wallSeconds);
+    printf("per frame         step %.3f ms, render and readback %.3f ms, encode wait %.3f ms\n",
+           stepTime * 1.0e-6 / frames, renderTime * 1.0e-6 / frames, _encodeWait * 1.0e-6 / frames);
+    printf("encoders          %d threads\n", _encoders.maxThreadCount());
+    return 0;
+}
+
+int runCapture(const QStringList &arguments){
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders a game world to PNG frames without a window.");
+    parser.addHelpOption();
+    QCommandLineOption captureOption("capture", "Directory to write the frames to.", "dir", "capture");
+    QCommandLineOption worldOption("world", "World to run: arcanoid, example or test.", "name", "arcanoid");
+    QCommandLineOption secondsOption("seconds", "Simulated time to capture.", "seconds", "10");
+    QCommandLineOption fpsOption("fps", "Frames per simulated second.", "fps", QString::number(RENDER_RATE));
+    QCommandLineOption sizeOption("size", "Frame size.", "WxH", "1920x1080");
+    QCommandLineOption verboseOption("verbose", "Keep the debug output of the worlds.");
+    parser.addOption(captureOption);
+    parser.addOption(worldOption);
+    parser.addOption(secondsOption);
+    parser.addOption(fpsOption);
+    parser.addOption(sizeOption);
+    parser.addOption(verboseOption);
+    parser.process(arguments);
+
+    if (!parser.isSet(verboseOption)) {
+        qInstallMessageHandler(quietMessageHandler);
+    }
+
+    const QStringList size = parser.value(sizeOption).split('x');
+    if (size.size() != 2 || size.at(0).toInt() <= 0 || size.at(1).toInt() <= 0) {
+        fprintf(stderr, "Bad frame size: %s\n", qPrintable(parser.value(sizeOption)));
+        return 1;
+    }
+
+    CaptureRunner runner;
+    runner.setDirectory(parser.value(captureOption));
+    runner.setWorld(parser.value(worldOption));
+    runner.setSeconds(parser.value(secondsOption).toDouble());
+    runner.setFramesPerSecond(qMax(1.0, parser.value(fpsOption).toDouble()));
+    runner.setSize(QSize(size.at(0).toInt(), size.at(1).toInt()));
+    return runner.run();
+}
@@ -0,0 +1,57 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <QObject>
+#include <QSemaphore>
+#include <QSize>
+#include <QStringList>
+#include <QThreadPool>
+
+class QImage;
+
+// Renders a game world to a PNG sequence without a window, for replays.
+// The world is stepped at its usual rate and drawn RENDER_RATE times per
+// simulated second by an OffscreenRenderer. While the GPU draws and reads
+// back a frame the world steps towards the next one, and finished frames
+// are encoded on a pool of worker threads, so stepping, drawing and
+// encoding overlap. Sustained frames per second go to stdout.
+class CaptureRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CaptureRunner(QObject *parent = 0);
+    ~CaptureRunner();
+
+    void setWorld(const QString &name)      { _worldName = name; }
+    void setSeconds(double seconds)         { _seconds = seconds; }
+    void setFramesPerSecond(double fps)     { _fps = fps; }
+    void setSize(const QSize &size)         { _size = size; }
+    void setDirectory(const QString &dir)   { _dir = dir; }
+
+    // Returns the process exit code.
+    int run();
+
+private slots:
+    void finishGame();
+
+private:
+    void write(const QImage &image);
+
+    QString      _worldName;
+    double       _seconds;
+    double       _fps;
+    QSize        _size;
+    QString      _dir;
+    bool         _gameFinished;
+
+    QThreadPool  _encoders;
+    QSemaphore   _encodeSlots;      // frames that may wait for a worker
+    int          _written;
+    qint64       _encodeWait;       // ns spent waiting for a free slot
+};
+
+// Parses the command line of a capture run and runs it.
+int runCapture(const QStringList &arguments);
+
+#endif // CAPTURE_H
@@ -0,0 +1,42 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <QAtomicInt>
+
+// Bounded single producer, single consumer ring without locks. One thread
+// pushes, another pops; Capacity must be a power of two and one slot stays
+// empty to tell a full ring from an empty one.
+template <typename T, int Capacity>
+class CommandQueue
+{
+public:
+    CommandQueue() : _head(0), _tail(0) {}
+
+    // Producer side. Returns false if the queue is full.
+    bool push(const T &value) {
+        int tail = _tail.loadAcquire();
+        int next = (tail + 1) & (Capacity - 1);
+        if (next == _head.loadAcquire())
+            return false;
+        _items[tail] = value;
+        _tail.storeRelease(next);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool pop(T *value) {
+        int head = _head.loadAcquire();
+        if (head == _tail.loadAcquire())
+            return false;
+        *value = _items[head];
+        _head.storeRelease((head + 1) & (Capacity - 1));
+        return true;
+    }
+
+private:
+    T          _items[Capacity];
+    QAtomicInt _head;
+    QAtomicInt _tail;
+};
+
+#endif // COMMANDQUEUE_H
@@ -2,7 +2,7 @@
 #define QBOX2DCONTACTLISTENER_H
 
 #include <Box2D.h>
-#include <QList>
+#include <QVector>
 #include "items.h"
 
 class ContactPoint;
@@ -18,14 +18,16 @@ public:
     virtual void PreSolve(b2Contact* contact, const b2Manifold* oldManifold);
     virtual void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse);
 
-    QList<ContactPoint> _contacts;
+    // Contacts in progress. A vector keeps its capacity, so begin and end
+    // of contacts stop allocating once the count settles.
+    QVector<ContactPoint> _contacts;
 };
 
 struct ContactPoint {
     QBox2DItem* itemA;
     QBox2DItem* itemB;
 
-    bool operator ==(const ContactPoint& other){
+    bool operator ==(const ContactPoint& other) const {
         if (this->itemA == other.itemA &&
             this->itemB == other.itemB) {
             return true;
@@ -11,6 +11,11 @@
 #define RESOURCE_DIR ( DATA_DIR "res/"      )
 
 
+// Steps and frames per second. Physics runs on its own thread and is
+// interpolated for drawing, the two rates are independent.
+#define PHYSICS_RATE 120
+#define RENDER_RATE  60
+
 #define PI 3.141592653589793238463
 #define ANG2RAD( a ) ( ( (a) * PI ) / 180.0f )
 #define RAD2ANG( a ) ( ( (a) * 180.0f ) / PI )
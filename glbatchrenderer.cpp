@@ -0,0 +1,375 @@
+#include "glbatchrenderer.h"
+#include "glshadermanager.h"
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QDebug>
+#include <cstddef>
+#include <cstring>
+
+uint qHash(const GLBatchRenderer::MeshKey &key, uint seed){
+    return qHashBits(key.vertices.constData(), key.vertices.size() * sizeof(QVector3D), seed) ^
+           qHashBits(key.textureCoordinates.constData(), key.textureCoordinates.size() * sizeof(QVector2D), seed);
+}
+
+GLBatchRenderer::GLBatchRenderer() :
+    _gl(NULL),
+    _shader(NULL),
+    _geometryBuffer(QOpenGLBuffer::VertexBuffer),
+    _instanceBuffer(QOpenGLBuffer::VertexBuffer),
+    _geometryDirty(false),
+    _drawCalls(0),
+    _textureBinds(0),
+    _shaderBinds(0),
+    _blendChanges(0)
+{
+}
+
+GLBatchRenderer::~GLBatchRenderer()
+{
+    _geometryBuffer.destroy();
+    _instanceBuffer.destroy();
+}
+
+bool GLBatchRenderer::initialize(const QString &shaderDir){
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    _gl = context->extraFunctions();
+
+    // glVertexAttribDivisor and glDrawArraysInstanced are core in OpenGL 3.3
+    // and ES 3.0, older contexts need the extensions. Without them the
+    // renderer stays unusable and draw() does nothing.
+    const QPair<int,int> version = context->format().version();
+    const bool core = context->isOpenGLES() ? version >= qMakePair(3, 0) : version >= qMakePair(3, 3);
+    if (!core && !(context->hasExtension("GL_ARB_instanced_arrays") &&
+                   context->hasExtension("GL_ARB_draw_instanced"))) {
+        qWarning() << "Instanced drawing needs OpenGL 3.3, OpenGL ES 3.0 or GL_ARB_instanced_arrays, got"
+                   << qPrintable(QString("%1 %2.%3").arg(context->isOpenGLES() ? "OpenGL ES" : "OpenGL")
+                                 .arg(version.first).arg(version.second));
+        return false;
+    }
+
+    // Shared with every renderer of the context, compiled once.
+    _shader = GLShaderManager::instance()->program(shaderDir + "instanced");
+    if (!_shader) {
+        return false;
+    }
+
+    // Looked up once, not by name on every draw.
+    _viewMatrixLocation        = _shader->uniformLocation("viewMatrix");
+    _projMatrixLocation        = _shader->uniformLocation("projMatrix");
+    _textureLocation           = _shader->uniformLocation("texture");
+    _vertexLocation            = _shader->attributeLocation("vertex");
+    _textureCoordinateLocation = _shader->attributeLocation("textureCoordinate");
+    _modelMatrixLocation       = _shader->attributeLocation("modelMatrix");
+    _colorLocation             = _shader->attributeLocation("color");
+    _textureRectLocation       = _shader->attributeLocation("textureRect");
+
+    _geometryBuffer.setUsagePattern(QOpenGLBuffer::StaticDraw);
+    _instanceBuffer.setUsagePattern(QOpenGLBuffer::StreamDraw);
+    return _geometryBuffer.create() && _instanceBuffer.create();
+}
+
+void GLBatchRenderer::begin(const QMatrix4x4 &viewMatrix, const QMatrix4x4 &projMatrix){
+    _viewMatrix = viewMatrix;
+    _projMatrix = projMatrix;
+    _projViewMatrix = projMatrix * viewMatrix;
+    _packets.resize(0);
+    _instances.resize(0);
+    _drawCalls = 0;
+    _textureBinds = 0;
+    _shaderBinds = 0;
+    _blendChanges = 0;
+}
+
+int GLBatchRenderer::findTexture(GLuint texture){
+    QHash<GLuint, int>::const_iterator i = _textureIndex.constFind(texture);
+    if (i != _textureIndex.constEnd()) return i.value();
+
+    _textures.append(texture);
+    _textureIndex.insert(texture, _textures.size() - 1);
+    return _textures.size() - 1;
+}
+
+int GLBatchRenderer::findMesh(const QVector<QVector3D> &vertices,
+                              const QVector<QVector2D> &textureCoordinates){
+    MeshKey key;
+    key.vertices = vertices;
+    key.textureCoordinates = textureCoordinates;
+
+    QHash<MeshKey, int>::const_iterator i = _meshIndex.constFind(key);
+    if (i != _meshIndex.constEnd()) return i.value();
+
+    // Split every quad into two triangles, like GL_QUADS would draw it.
+    static const int corners[6] = { 0, 1, 2, 0, 2, 3 };
+    Mesh mesh;
+    mesh.first = _geometry.size() / 5;
+    mesh.count = 0;
+    for (int quad = 0; quad + 4 <= vertices.size(); quad += 4) {
+        for (int k = 0; k < 6; ++k) {
+            int v = quad + corners[k];
+            QVector2D st = v < textureCoordinates.size() ? textureCoordinates.at(v) : QVector2D();
+            _geometry << vertices.at(v).x() << vertices.at(v).y() << vertices.at(v).z()
+                      << st.x() << st.y();
+        }
+        mesh.count += 6;
+    }
+
+    _meshes.append(mesh);
+    _meshIndex.insert(key, _meshes.size() - 1);
+    _geometryDirty = true;
+    return _meshes.size() - 1;
+}
+
+namespace {
+
+const quint64 TranslucentBit = Q_UINT64_C(1) << 55;
+
+// The only program so far, its bits in the key are there for more.
+const quint64 InstancedShader = 0;
+
+quint64 sortKey(int layer, bool translucent, int texture, int mesh, quint16 depth){
+    const quint64 state = (InstancedShader << 32) | (quint64(texture) << 16) | quint64(mesh);
+    quint64 key = quint64(qBound(0, layer, 255)) << 56;
+    if (translucent) {
+        // Back to front: farther items have smaller keys.
+        key |= TranslucentBit | (quint64(quint16(0xffff - depth)) << 39) | state;
+    } else {
+        key |= (state << 16) | depth;
+    }
+    return key;
+}
+
+}
+
+void GLBatchRenderer::add(const GLAtlasRegion &region,
+                          const QVector<QVector3D> &vertices,
+                          const QVector<QVector2D> &textureCoordinates,
+                          const QMatrix4x4 &modelMatrix,
+                          const QColor &color,
+                          int layer){
+    if (vertices.size() < 4) return;
+
+    const int index = _packets.size();
+    resize(index + 1);
+    resolve(index, region, vertices, textureCoordinates, modelMatrix, color, layer);
+}
+
+void GLBatchRenderer::resize(int count){
+    _packets.resize(count);
+    _instances.resize(count);
+}
+
+bool GLBatchRenderer::set(int index,
+                          const GLAtlasRegion &region,
+                          const QVector<QVector3D> &vertices,
+                          const QVector<QVector2D> &textureCoordinates,
+                          const QMatrix4x4 &modelMatrix,
+                          const QColor &color,
+                          int layer){
+    QHash<QPair<const void*, const void*>, int>::const_iterator mesh =
+            _meshByData.constFind(qMakePair<const void*, const void*>(vertices.constData(),
+                                                                      textureCoordinates.constData()));
+    if (mesh == _meshByData.constEnd()) return false;
+    QHash<GLuint, int>::const_iterator texture = _textureIndex.constFind(region.texture);
+    if (texture == _textureIndex.constEnd()) return false;
+
+    write(index, texture.value(), mesh.value(), region.translucent, region.rect, modelMatrix, color, layer);
+    return true;
+}
+
+void GLBatchRenderer::resolve(int index,
+                              const GLAtlasRegion &region,
+                              const QVector<QVector3D> &vertices,
+                              const QVector<QVector2D> &textureCoordinates,
+                              const QMatrix4x4 &modelMatrix,
+                              const QColor &color,
+                              int layer){
+    const QPair<const void*, const void*> data(vertices.constData(), textureCoordinates.constData());
+    int mesh = _meshByData.value(data, -1);
+    if (mesh < 0) {
+        mesh = findMesh(vertices, textureCoordinates);
+        MeshKey key;
+        key.vertices = vertices;
+        key.textureCoordinates = textureCoordinates;
+        _meshData.append(key);
+        _meshByData.insert(data, mesh);
+    }
+    const int texture = findTexture(region.texture);
+
+    write(index, texture, mesh, region.translucent, region.rect, modelMatrix, color, layer);
+}
+
+void GLBatchRenderer::write(int index, int texture, int mesh, bool translucent,
+                            const QVector4D &textureRect, const QMatrix4x4 &modelMatrix,
+                            const QColor &color, int layer){
+    Q_ASSERT(mesh <= 0xffff && texture <= 0xffff);
+
+    // Depth of the item origin in normalized device coordinates, near is 0.
+    const QVector4D origin = _projViewMatrix * modelMatrix.column(3);
+    const float z = origin.w() != 0 ? origin.z() / origin.w() : 0.0f;
+    const quint16 depth = quint16(qBound(0.0f, z * 0.5f + 0.5f, 1.0f) * 0xffff);
+
+    Packet &packet = _packets[index];
+    packet.key = sortKey(layer, translucent || color.alpha() < 255, texture, mesh, depth);
+    packet.instance = index;
+    packet.texture = texture;
+    packet.mesh = mesh;
+
+    Instance &instance = _instances[index];
+    memcpy(instance.modelMatrix, modelMatrix.constData(), sizeof(instance.modelMatrix));
+    instance.color[0] = color.redF();
+    instance.color[1] = color.greenF();
+    instance.color[2] = color.blueF();
+    instance.color[3] = color.alphaF();
+    instance.textureRect[0] = textureRect.x();
+    instance.textureRect[1] = textureRect.y();
+    instance.textureRect[2] = textureRect.z();
+    instance.textureRect[3] = textureRect.w();
+}
+
+void GLBatchRenderer::sortPackets(){
+    // Least significant byte first, eight stable counting passes. Passes
+    // over a byte all keys share are skipped, with few layers, shaders and
+    // textures that is about half of them.
+    const int count = _packets.size();
+    _sortBuffer.resize(count);
+    Packet *from = _packets.data();
+    Packet *to = _sortBuffer.data();
+    for (int shift = 0; shift < 64; shift += 8) {
+        int offsets[256];
+        memset(offsets, 0, sizeof(offsets));
+        for (int i = 0; i < count; ++i) {
+            ++offsets[(from[i].key >> shift) & 0xff];
+        }
+        if (offsets[(from[0].key >> shift) & 0xff] == count) continue;
+
+        int offset = 0;
+        for (int digit = 0; digit < 256; ++digit) {
+            const int n = offsets[digit];
+            offsets[digit] = offset;
+            offset += n;
+        }
+        for (int i = 0; i < count; ++i) {
+            to[offsets[(from[i].key >> shift) & 0xff]++] = from[i];
+        }
+        qSwap(from, to);
+    }
+    if (from != _packets.data()) {
+        _packets.swap(_sortBuffer);
+    }
+}
+
+void GLBatchRenderer::setInstanceAttributes(int firstInstance){
+    // Without base instance drawing the per-instance arrays are pointed at
+    // the batch instead.
+    const int stride = sizeof(Instance);
+    const size_t base = size_t(firstInstance) * stride;
+    for (int column = 0; column < 4; ++column) {
+        _gl->glVertexAttribPointer(_modelMatrixLocation + column, 4, GL_FLOAT, GL_FALSE, stride,
+                                   reinterpret_cast<const void*>(base + column * 4 * sizeof(GLfloat)));
+    }
+    _gl->glVertexAttribPointer(_colorLocation, 4, GL_FLOAT, GL_FALSE, stride,
+                               reinterpret_cast<const void*>(base + offsetof(Instance, color)));
+    _gl->glVertexAttribPointer(_textureRectLocation, 4, GL_FLOAT, GL_FALSE, stride,
+                               reinterpret_cast<const void*>(base + offsetof(Instance, textureRect)));
+}
+
+void GLBatchRenderer::draw(){
+    if (_packets.isEmpty() || !_shader) return;
+
+    sortPackets();
+    const int count = _packets.size();
+
+    _shader->bind();
+    ++_shaderBinds;
+    _shader->setUniformValue(_viewMatrixLocation, _viewMatrix);
+    _shader->setUniformValue(_projMatrixLocation, _projMatrix);
+    _shader->setUniformValue(_textureLocation, 0);
+
+    _geometryBuffer.bind();
+    if (_geometryDirty) {
+        _geometryBuffer.allocate(_geometry.constData(), _geometry.size() * sizeof(GLfloat));
+        _geometryDirty = false;
+    }
+    const int vertexStride = 5 * sizeof(GLfloat);
+    _gl->glEnableVertexAttribArray(_vertexLocation);
+    _gl->glVertexAttribPointer(_vertexLocation, 3, GL_FLOAT, GL_FALSE, vertexStride, 0);
+    _gl->glEnableVertexAttribArray(_textureCoordinateLocation);
+    _gl->glVertexAttribPointer(_textureCoordinateLocation, 2, GL_FLOAT, GL_FALSE, vertexStride,
+                               reinterpret_cast<const void*>(3 * sizeof(GLfloat)));
+
+    // One upload for the whole frame, in drawing order. allocate orphans
+    // last frame's storage, so the driver does not wait for draws still
+    // reading it.
+    _sortedInstances.resize(count);
+    for (int i = 0; i < count; ++i) {
+        _sortedInstances[i] = _instances.at(_packets.at(i).instance);
+    }
+    _instanceBuffer.bind();
+    _instanceBuffer.allocate(_sortedInstances.constData(), count * sizeof(Instance));
+
+    for (int column = 0; column < 4; ++column) {
+        _gl->glEnableVertexAttribArray(_modelMatrixLocation + column);
+        _gl->glVertexAttribDivisor(_modelMatrixLocation + column, 1);
+    }
+    _gl->glEnableVertexAttribArray(_colorLocation);
+    _gl->glVertexAttribDivisor(_colorLocation, 1);
+    _gl->glEnableVertexAttribArray(_textureRectLocation);
+    _gl->glVertexAttribDivisor(_textureRectLocation, 1);
+
+    // A run is packets with the same texture, shape and blending; each is
+    // one draw, state is only set where it differs from the previous run.
+    const bool blendWasEnabled = glIsEnabled(GL_BLEND);
+    bool blending = blendWasEnabled;
+    int boundTexture = -1;
+    int first = 0;
+    for (int i = 1; i <= count; ++i) {
+        const Packet &packet = _packets.at(first);
+        if (i < count) {
+            const Packet &next = _packets.at(i);
+            if (next.texture == packet.texture && next.mesh == packet.mesh &&
+                (next.key & TranslucentBit) == (packet.key & TranslucentBit)) {
+                continue;
+            }
+        }
+
+        const Mesh &mesh = _meshes.at(packet.mesh);
+        if (mesh.count == 0) {
+            // Fewer than four vertices, nothing to draw.
+            first = i;
+            continue;
+        }
+
+        const bool translucent = packet.key & TranslucentBit;
+        if (translucent != blending) {
+            if (translucent) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+            blending = translucent;
+            ++_blendChanges;
+        }
+        if (packet.texture != boundTexture) {
+            glBindTexture(GL_TEXTURE_2D, _textures.at(packet.texture));
+            boundTexture = packet.texture;
+            ++_textureBinds;
+        }
+        setInstanceAttributes(first);
+        _gl->glDrawArraysInstanced(GL_TRIANGLES, mesh.first, mesh.count, i - first);
+        ++_drawCalls;
+        first = i;
+    }
+    if (blending != blendWasEnabled) {
+        if (blendWasEnabled) glEnable(GL_BLEND); else glDisable(GL_BLEND);
+    }
+
+    // Leave the attribute state as plain per-vertex arrays for other code.
+    for (int column = 0; column < 4; ++column) {
+        _gl->glVertexAttribDivisor(_modelMatrixLocation + column, 0);
+        _gl->glDisableVertexAttribArray(_modelMatrixLocation + column);
+    }
+    _gl->glVertexAttribDivisor(_colorLocation, 0);
+    _gl->glDisableVertexAttribArray(_colorLocation);
+    _gl->glVertexAttribDivisor(_textureRectLocation, 0);
+    _gl->glDisableVertexAttribArray(_textureRectLocation);
+    _gl->glDisableVertexAttribArray(_vertexLocation);
+    _gl->glDisableVertexAttribArray(_textureCoordinateLocation);
+    _instanceBuffer.release();
+    _shader->release();
+}
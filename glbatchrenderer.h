@@ -0,0 +1,169 @@
+#ifndef GLBATCHRENDERER_H
+#define GLBATCHRENDERER_H
+
+#include <QColor>
+#include <QHash>
+#include <QMatrix4x4>
+#include <QGLShaderProgram>
+#include <QOpenGLBuffer>
+#include <QPair>
+#include <QVector>
+#include <QVector2D>
+#include <QVector3D>
+#include "gltextureatlas.h"
+
+class QOpenGLExtraFunctions;
+
+// Draws many items with few GL calls. Item geometry is kept once per
+// distinct shape in a static vertex buffer; the model matrix, color and
+// atlas rectangle of every item go into an instance buffer that is refilled
+// each frame, and runs of items with the same state are drawn by one
+// instanced call. Needs instanced arrays (OpenGL 3.3 or ES 3.0).
+//
+// Items are queued as draw packets with a 64 bit sort key and radix sorted
+// before drawing, so items sharing a texture and shape end up next to each
+// other whatever order they were added in. From the most significant bits:
+//
+//   opaque:      layer 8 | 0 | shader 7 | texture 16 | mesh 16 | depth 16
+//   translucent: layer 8 | 1 | depth 16 | shader 7 | texture 16 | mesh 16
+//
+// Opaque items draw front to back within a state, translucent ones after
+// them back to front, which blending needs more than fewer state changes.
+// While drawing, the program, texture and blending are only set when they
+// differ from the previous run.
+class GLBatchRenderer
+{
+public:
+    GLBatchRenderer();
+    ~GLBatchRenderer();
+
+    // Compile the shaders and create the buffers. The GL context must be
+    // current, here and in every call below.
+    bool initialize(const QString &shaderDir);
+
+    // Start collecting a frame seen through the given matrices.
+    void begin(const QMatrix4x4 &viewMatrix, const QMatrix4x4 &projMatrix);
+
+    // Queue an item. Vertices are groups of four like GL_QUADS, texture
+    // coordinates are relative to the region. Lower layers draw first.
+    void add(const GLAtlasRegion &region,
+             const QVector<QVector3D> &vertices,
+             const QVector<QVector2D> &textureCoordinates,
+             const QMatrix4x4 &modelMatrix,
+             const QColor &color,
+             int layer = 0);
+
+    // Filling a frame from several threads, see GLCommandBuilder: size the
+    // frame for count items, then set every index once. set may run on any
+    // thread while the GL thread waits; it only looks up shapes and
+    // textures drawn before and returns false for a new one. Such items
+    // must then be resolved on the GL thread, which adds what they need.
+    void resize(int count);
+    bool set(int index,
+             const GLAtlasRegion &region,
+             const QVector<QVector3D> &vertices,
+             const QVector<QVector2D> &textureCoordinates,
+             const QMatrix4x4 &modelMatrix,
+             const QColor &color,
+             int layer);
+    void resolve(int index,
+                 const GLAtlasRegion &region,
+                 const QVector<QVector3D> &vertices,
+                 const QVector<QVector2D> &textureCoordinates,
+                 const QMatrix4x4 &modelMatrix,
+                 const QColor &color,
+                 int layer);
+
+    // Sort and draw everything queued since begin().
+    void draw();
+
+    // Counts of the last draw(), state changes are those actually issued.
+    int drawCalls()    const { return _drawCalls; }
+    int textureBinds() const { return _textureBinds; }
+    int shaderBinds()  const { return _shaderBinds; }
+    int blendChanges() const { return _blendChanges; }
+    int instances()    const { return _packets.size(); }
+
+private:
+    struct Mesh {
+        int first;      // first vertex in the geometry buffer
+        int count;      // triangle vertices
+    };
+
+    struct Instance {
+        GLfloat modelMatrix[16];
+        GLfloat color[4];
+        GLfloat textureRect[4];
+    };
+
+    // What the sort moves around, the instance data stays in place.
+    struct Packet {
+        quint64 key;
+        quint32 instance;   // index in _instances
+        quint16 texture;    // index in _textures
+        quint16 mesh;
+    };
+
+    // Shapes are found by content, items of the same size share a mesh.
+    // The vectors are implicitly shared with the items, keys do not copy.
+    struct MeshKey {
+        QVector<QVector3D> vertices;
+        QVector<QVector2D> textureCoordinates;
+
+        bool operator==(const MeshKey &other) const {
+            return vertices == other.vertices && textureCoordinates == other.textureCoordinates;
+        }
+    };
+    friend uint qHash(const MeshKey &key, uint seed);
+
+    int  findMesh(const QVector<QVector3D> &vertices, const QVector<QVector2D> &textureCoordinates);
+    int  findTexture(GLuint texture);
+    void write(int index, int texture, int mesh, bool translucent,
+               const QVector4D &textureRect, const QMatrix4x4 &modelMatrix,
+               const QColor &color, int layer);
+    void sortPackets();
+    void setInstanceAttributes(int firstInstance);
+
+    QOpenGLExtraFunctions*  _gl;
+    QGLShaderProgram*       _shader;            // owned by GLShaderManager
+    QOpenGLBuffer           _geometryBuffer;
+    QOpenGLBuffer           _instanceBuffer;
+
+    QVector<GLfloat>        _geometry;          // x y z s t per vertex
+    bool                    _geometryDirty;
+    QVector<Mesh>           _meshes;
+    QHash<MeshKey, int>     _meshIndex;
+    // Meshes by the address of the vectors, a lookup without hashing the
+    // content or touching the shared reference counts. The keys keep the
+    // vectors alive, so an address is never reused for another shape.
+    QHash<QPair<const void*, const void*>, int> _meshByData;
+    QVector<MeshKey>        _meshData;
+    QVector<GLuint>         _textures;          // GL names by sort key index
+    QHash<GLuint, int>      _textureIndex;
+
+    // Reused every frame, so none of them allocates once the item count
+    // settles.
+    QVector<Packet>         _packets;
+    QVector<Packet>         _sortBuffer;
+    QVector<Instance>       _instances;         // in the order added
+    QVector<Instance>       _sortedInstances;   // in the order drawn
+
+    QMatrix4x4              _viewMatrix;
+    QMatrix4x4              _projMatrix;
+    QMatrix4x4              _projViewMatrix;
+    int                     _drawCalls;
+    int                     _textureBinds;
+    int                     _shaderBinds;
+    int                     _blendChanges;
+
+    int _viewMatrixLocation;
+    int _projMatrixLocation;
+    int _textureLocation;
+    int _vertexLocation;
+    int _textureCoordinateLocation;
+    int _modelMatrixLocation;
+    int _colorLocation;
+    int _textureRectLocation;
+};
+
+#endif // GLBATCHRENDERER_H
@@ -23,3 +23,19 @@ QMatrix4x4& GLCamera::viewMatrix() {
 QMatrix4x4 GLCamera::projViewProduct() const {
     return _projMatrix * _viewMatrix;
 }
+
+QRectF GLCamera::visibleRect() const {
+    // Corners of the viewport in world units. With an orthographic
+    // projection their bounding rectangle is exact.
+    const QMatrix4x4 inverse = projViewProduct().inverted();
+    const QVector3D corners[] = { inverse.map(QVector3D(-1, -1, 0)), inverse.map(QVector3D(1, -1, 0)),
+                                  inverse.map(QVector3D(-1,  1, 0)), inverse.map(QVector3D(1,  1, 0)) };
+    qreal left = corners[0].x(), right = left, top = corners[0].y(), bottom = top;
+    for (int i = 1; i < 4; ++i) {
+        left   = qMin<qreal>(left,   corners[i].x());
+        right  = qMax<qreal>(right,  corners[i].x());
+        top    = qMin<qreal>(top,    corners[i].y());
+        bottom = qMax<qreal>(bottom, corners[i].y());
+    }
+    return QRectF(QPointF(left, top), QPointF(right, bottom));
+}
@@ -2,6 +2,7 @@
 #define GLCAMERA_H
 
 #include <QMatrix4x4>
+#include <QRectF>
 
 class GLCamera
 {
@@ -13,6 +14,10 @@ public:
     QMatrix4x4& viewMatrix();
     QMatrix4x4  projViewProduct() const;
 
+    // World rectangle in the viewport, on the z = 0 plane. Exact for
+    // orthographic projections.
+    QRectF      visibleRect() const;
+
 private:
     QMatrix4x4 _projMatrix;
     QMatrix4x4 _viewMatrix;
@@ -0,0 +1,96 @@
+#include "glcommandbuilder.h"
+#include "glbatchrenderer.h"
+#include "gltextureatlas.h"
+#include <QThread>
+
+namespace {
+
+// Below this many items per thread, starting the threads costs more than
+// it saves.
+const int MinimumSlice = 2048;
+
+// Items without a body, like the sky, are the background layer.
+int layer(const RenderItem &item) {
+    return item.hasBody ? 1 : 0;
+}
+
+}
+
+GLCommandBuilder::Slice::Slice() :
+    snapshot(NULL),
+    atlas(NULL),
+    renderer(NULL),
+    alpha(1.0f),
+    begin(0),
+    end(0)
+{
+    // Reused every frame.
+    setAutoDelete(false);
+}
+
+void GLCommandBuilder::Slice::run(){
+    b2TraceZone("GLCommandBuilder::Slice");
+    missed.resize(0);
+    for (int i = begin; i < end; ++i) {
+        const RenderItem &item = snapshot->items.at(i);
+        GLAtlasRegion region;
+        if (!atlas->findRegion(item.textureName, &region) ||
+            !renderer->set(i, region, item.vertices, item.textureCoordinates,
+                           item.interpolatedMatrix(alpha), item.color, layer(item))) {
+            missed.append(i);
+        }
+    }
+}
+
+GLCommandBuilder::GLCommandBuilder()
+{
+    // The calling thread builds a slice as well.
+    _pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+    // Keep the workers between frames.
+    _pool.setExpiryTimeout(-1);
+    for (int i = 0; i < threadCount(); ++i) {
+        _slices.append(new Slice);
+    }
+}
+
+GLCommandBuilder::~GLCommandBuilder()
+{
+    _pool.waitForDone();
+    qDeleteAll(_slices);
+}
+
+void GLCommandBuilder::build(const WorldSnapshot &snapshot, float32 alpha,
+                             GLTextureAtlas &atlas, GLBatchRenderer &renderer){
+    b2TraceZone("GLCommandBuilder::build");
+    const int count = snapshot.items.size();
+    renderer.resize(count);
+
+    const int slices = qBound(1, count / MinimumSlice, _slices.size());
+    for (int i = 0; i < slices; ++i) {
+        Slice *slice = _slices.at(i);
+        slice->snapshot = &snapshot;
+        slice->atlas = &atlas;
+        slice->renderer = &renderer;
+        slice->alpha = alpha;
+        slice->begin = qint64(count) * i / slices;
+        slice->end = qint64(count) * (i + 1) / slices;
+    }
+
+    // Nothing may change the atlas or the renderer's lookups until all
+    // slices are done, the workers only read them.
+    for (int i = 1; i < slices; ++i) {
+        _pool.start(_slices.at(i));
+    }
+    _slices.at(0)->run();
+    _pool.waitForDone();
+
+    for (int i = 0; i < slices; ++i) {
+        const QVector<int> &missed = _slices.at(i)->missed;
+        for (int k = 0; k < missed.size(); ++k) {
+            const RenderItem &item = snapshot.items.at(missed.at(k));
+            renderer.resolve(missed.at(k), atlas.region(item.textureName), item.vertices,
+                             item.textureCoordinates, item.interpolatedMatrix(alpha),
+                             item.color, layer(item));
+        }
+    }
+}
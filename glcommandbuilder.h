@@ -0,0 +1,51 @@
+#ifndef GLCOMMANDBUILDER_H
+#define GLCOMMANDBUILDER_H
+
+#include <QRunnable>
+#include <QThreadPool>
+#include <QVector>
+#include "items.h"
+
+class GLBatchRenderer;
+class GLTextureAtlas;
+
+// Turns a snapshot into the renderer's draw packets and instances on
+// several threads. The items are split into one slice per thread; each
+// thread interpolates the poses of its slice and writes them to its part
+// of the renderer's frame, the GL thread works on a slice too and then
+// only sorts, uploads and draws. Items with a shape or texture not seen
+// before are finished on the GL thread, which may have to load them.
+class GLCommandBuilder
+{
+public:
+    GLCommandBuilder();
+    ~GLCommandBuilder();
+
+    // Fill the renderer, between its begin() and draw(). Blocks until all
+    // items are written. The GL context must be current.
+    void build(const WorldSnapshot &snapshot, float32 alpha,
+               GLTextureAtlas &atlas, GLBatchRenderer &renderer);
+
+    // Threads a large frame is split over, the calling one included.
+    int threadCount() const { return _pool.maxThreadCount() + 1; }
+
+private:
+    class Slice : public QRunnable {
+    public:
+        Slice();
+        void run();
+
+        const WorldSnapshot* snapshot;
+        const GLTextureAtlas* atlas;
+        GLBatchRenderer*      renderer;
+        float32               alpha;
+        int                   begin;
+        int                   end;
+        QVector<int>          missed;   // items left for the GL thread
+    };
+
+    QThreadPool     _pool;
+    QVector<Slice*> _slices;
+};
+
+#endif // GLCOMMANDBUILDER_H
@@ -1,7 +1,26 @@
 #include <QtOpenGL>
 #include "glscene.h"
+#include "glshadermanager.h"
 
-GLScene::GLScene(QWidget *parent) : QGLWidget(parent)
+namespace {
+
+// Time each frame may spend packing and uploading loaded textures, in ns.
+const qint64 TextureUploadBudget = 2000000;
+
+// The batch renderer draws instanced, core in OpenGL 3.3. The compatibility
+// profile keeps the fixed-function state the scene still sets.
+QGLFormat sceneFormat() {
+    QGLFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QGLFormat::CompatibilityProfile);
+    return format;
+}
+
+}
+
+GLScene::GLScene(QWidget *parent) : QGLWidget(sceneFormat(), parent),
+    _snapshots(NULL),
+    _clock(NULL)
 {
     setFocusPolicy(Qt::StrongFocus);
     setSizePolicy(QSizePolicy::Expanding,QSizePolicy::Expanding);
@@ -18,7 +37,8 @@ GLScene::GLScene(QWidget *parent) : QGLWidget(parent)
 
 GLScene::~GLScene()
 {
-
+    // The renderer frees its buffers in this context.
+    makeCurrent();
 }
 
 void GLScene::resizeGL(int width, int height)
@@ -45,26 +65,67 @@ void GLScene::initializeGL(){
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
 
-    _shader.addShaderFromSourceFile(QGLShader::Vertex, _shader_dir + "texture.vsh" );
-    _shader.addShaderFromSourceFile(QGLShader::Fragment, _shader_dir + "texture.fsh" );
-    _shader.link();
+    // Every program of the shader directory is linked once per process;
+    // later scenes and runs load the binaries.
+    GLShaderManager *shaders = GLShaderManager::instance();
+    shaders->preload(_shader_dir);
+    if (!_renderer.initialize(_shader_dir)) {
+        qDebug() << "Cannot initialize the renderer";
+    }
+    qDebug() << "Shaders:" << shaders->compiled() << "compiled," << shaders->binaryLoads() << "from binaries";
+    _atlas.build(_texture_dir);
+    _statisticsTimer.start();
 
     emit initialized();
     qDebug() << "GL Scene initialized";
 }
 
 void GLScene::paintGL() {
+    b2TraceZone("GLScene::paintGL");
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     camera().viewMatrix().setToIdentity();
     camera().lookAt(QVector3D(0, 0, 0));
     camera().viewMatrix().scale(_scale);
 
-    QListIterator<QBox2DItem*> i(_glitems);
-    while(i.hasNext()){
-        QBox2DItem *item = i.next();
-        item->draw();
+    if (!_snapshots) return;
+
+    // The world snapshots only what is in view. The margin covers items
+    // moving in before the next snapshot is published.
+    QRectF view = camera().visibleRect();
+    view.adjust(-0.1 * view.width(), -0.1 * view.height(), 0.1 * view.width(), 0.1 * view.height());
+    if (view != _view) {
+        _view = view;
+        emit viewChanged(_view);
     }
+
+    // Whatever the physics thread published last, no locking.
+    const WorldSnapshot &snapshot = _snapshots->read();
+
+    // Show the world one physics step in the past, between the poses
+    // before and after the last step.
+    float32 alpha = 1.0f;
+    if (_clock && snapshot.timeStep > 0) {
+        alpha = float32(_clock->nsecsElapsed() - snapshot.time) / snapshot.timeStep;
+        alpha = qBound(0.0f, alpha, 1.0f);
+    }
+
+    _atlas.update(TextureUploadBudget);
+    _renderer.begin(camera().viewMatrix(), camera().projMatrix());
+    _commandBuilder.build(snapshot, alpha, _atlas, _renderer);
+    _renderer.draw();
+
+#if defined(B2_TRACE)
+    // Only in tracing builds, next to the timeline.
+    if (_statisticsTimer.elapsed() >= 1000) {
+        qDebug() << "Frame:" << _renderer.instances() << "items," << snapshot.culled << "culled,"
+                 << _renderer.drawCalls() << "draws," << _renderer.shaderBinds() << "shader binds,"
+                 << _renderer.textureBinds() << "texture binds," << _renderer.blendChanges()
+                 << "blend changes; atlas" << _atlas.pageCount() << "pages,"
+                 << qRound(_atlas.occupancy() * 100) << "% used," << _atlas.loading() << "loading";
+        _statisticsTimer.restart();
+    }
+#endif
 }
 
 void GLScene::updateGL() {
@@ -147,38 +208,22 @@ QSize GLScene::sizeHint() const {
     return QSize(640,480);
 }
 
-void GLScene::addItem(QBox2DItem *item)    {
-    //qDebug() << "Add item: " << item->name();
-    _glitems << item;
-    item->_glscene = this;
-    if (!item->textureName().isNull()) {
-        if (!_textures.contains(item->textureName())) {
-            qDebug() << "Loading texture: " << item->textureName();
-            GLuint textureID =
-                    bindTexture(QPixmap( _texture_dir + item->textureName()),
-                                GL_TEXTURE_2D);
-            _textures.insert(item->textureName(), textureID);
-        }
-    }
+void GLScene::setSnapshots(TripleBuffer<WorldSnapshot> *snapshots, const QElapsedTimer *clock) {
+    _snapshots = snapshots;
+    _clock = clock;
+    // A new world has no view yet.
+    _view = QRectF();
 }
 
-void GLScene::removeItem(QBox2DItem *item) {
-    qDebug() << "Remove item: " << item->name();
-    _glitems.removeOne(item);
-}
 void GLScene::zoomIn()   { _scale *= 1.1; }
 void GLScene::zoomOut()  { _scale *= 0.9; }
-void GLScene::clear()    { _glitems.clear(); }
+void GLScene::clear()    { setSnapshots(NULL, NULL); }
 
 GLCamera& GLScene::camera() {
     return _camera;
 }
 
-QHash<QString,GLuint>& GLScene::textures(){
-    return _textures;
-}
-
-QGLShaderProgram* GLScene::shader(){
-    return &_shader;
+GLTextureAtlas& GLScene::atlas(){
+    return _atlas;
 }
 
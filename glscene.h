@@ -2,10 +2,15 @@
 #define GLSCENE_H
 
 #include <QGLWidget>
+#include <QElapsedTimer>
+#include <QGLShaderProgram>
 #include <QtGui/QMouseEvent>
 #include <QtGui/QKeyEvent>
 #include "items.h"
 #include "glcamera.h"
+#include "triplebuffer.h"
+#include "glbatchrenderer.h"
+#include "glcommandbuilder.h"
 
 class GLScene : public QGLWidget
 {
@@ -16,16 +21,16 @@ public:
     virtual ~GLScene();
 
     GLCamera& camera();
-    QHash<QString,GLuint>& textures();
-    QGLShaderProgram* shader();
+    GLTextureAtlas& atlas();
     QString               _shader_dir;
     QString               _texture_dir;
 
+    // Draw what the physics thread publishes, interpolated to the time of
+    // the paint on the snapshots' clock. NULL draws nothing.
+    void setSnapshots(TripleBuffer<WorldSnapshot> *snapshots, const QElapsedTimer *clock);
 
 public slots:
     void updateGL();
-    void addItem(QBox2DItem *item);
-    void removeItem(QBox2DItem *item);
     void zoomIn();
     void zoomOut();
     void clear();
@@ -53,13 +58,19 @@ signals:
     void keyPressed(const int&);
     void keyReleased(const int&);
     void initialized();
+    // World rectangle the scene shows, with a margin. Sent when it changes.
+    void viewChanged(const QRectF&);
 
 private:
     qreal _alpha, _beta, _distance, _scale;
     GLCamera              _camera;
-    QGLShaderProgram      _shader;
-    QHash<QString,GLuint> _textures;
-    QList<QBox2DItem*>    _glitems;
+    GLBatchRenderer       _renderer;
+    GLCommandBuilder      _commandBuilder;
+    GLTextureAtlas        _atlas;
+    QElapsedTimer         _statisticsTimer;
+    TripleBuffer<WorldSnapshot>* _snapshots;
+    const QElapsedTimer*  _clock;
+    QRectF                _view;
 };
 
 #endif // GLSCENE_H
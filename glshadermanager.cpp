@@ -0,0 +1,179 @@
+#include "glshadermanager.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QDebug>
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#endif
+#ifndef GL_PROGRAM_BINARY_LENGTH
+#define GL_PROGRAM_BINARY_LENGTH 0x8741
+#endif
+#ifndef GL_NUM_PROGRAM_BINARY_FORMATS
+#define GL_NUM_PROGRAM_BINARY_FORMATS 0x87FE
+#endif
+
+GLShaderManager* GLShaderManager::instance(){
+    static GLShaderManager manager;
+    return &manager;
+}
+
+GLShaderManager::GLShaderManager() :
+    _cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/shaders"),
+    _compiled(0),
+    _binaryLoads(0)
+{
+}
+
+GLShaderManager::~GLShaderManager()
+{
+}
+
+QGLShaderProgram* GLShaderManager::program(const QString &source){
+    // The same program by any relative path.
+    const QString path = QFileInfo(source).absoluteFilePath();
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if (!context) return NULL;
+
+    if (!_programs.contains(context)) {
+        // Programs die with their context.
+        connect(context, SIGNAL(aboutToBeDestroyed()), this, SLOT(contextDestroyed()), Qt::DirectConnection);
+    }
+    QHash<QString, QGLShaderProgram*> &programs = _programs[context];
+    QHash<QString, QGLShaderProgram*>::const_iterator i = programs.constFind(path);
+    if (i != programs.constEnd()) return i.value();
+
+    QGLShaderProgram *program = link(path);
+    programs.insert(path, program);
+    return program;
+}
+
+void GLShaderManager::preload(const QString &dir){
+    QStringList filters;
+    filters << "*.vsh";
+    foreach (const QFileInfo &file, QDir(dir).entryInfoList(filters, QDir::Files)) {
+        const QString path = file.absolutePath() + "/" + file.completeBaseName();
+        if (QFile::exists(path + ".fsh")) {
+            program(path);
+        }
+    }
+}
+
+void GLShaderManager::contextDestroyed(){
+    QOpenGLContext *context = static_cast<QOpenGLContext*>(sender());
+    qDeleteAll(_programs.value(context));
+    _programs.remove(context);
+}
+
+bool GLShaderManager::binariesSupported(){
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    const QPair<int, int> version = context->format().version();
+    const bool core = context->isOpenGLES() ? version >= qMakePair(3, 0) : version >= qMakePair(4, 1);
+    if (!core && !context->hasExtension("GL_ARB_get_program_binary")) return false;
+
+    GLint formats = 0;
+    context->functions()->glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    return formats > 0;
+}
+
+QGLShaderProgram* GLShaderManager::link(const QString &path){
+    QFile vertexFile(path + ".vsh");
+    QFile fragmentFile(path + ".fsh");
+    if (!vertexFile.open(QIODevice::ReadOnly) || !fragmentFile.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot read shader" << path;
+        return NULL;
+    }
+    const QByteArray vertexSource = vertexFile.readAll();
+    const QByteArray fragmentSource = fragmentFile.readAll();
+
+    QOpenGLExtraFunctions *gl = QOpenGLContext::currentContext()->extraFunctions();
+    const bool binaries = binariesSupported();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertexSource);
+    hash.addData("\0", 1);
+    hash.addData(fragmentSource);
+    hash.addData("\0", 1);
+    hash.addData(reinterpret_cast<const char*>(gl->glGetString(GL_VENDOR)));
+    hash.addData(reinterpret_cast<const char*>(gl->glGetString(GL_RENDERER)));
+    hash.addData(reinterpret_cast<const char*>(gl->glGetString(GL_VERSION)));
+    const QByteArray key = hash.result().toHex();
+
+    Binary binary;
+    if (binaries && loadBinary(key, &binary)) {
+        // QGLShaderProgram::link keeps a program that is already linked
+        // when it has no shaders, which is how binaries get in.
+        QGLShaderProgram *program = new QGLShaderProgram;
+        gl->glProgramBinary(program->programId(), binary.format, binary.data.constData(), binary.data.size());
+        if (program->link()) {
+            ++_binaryLoads;
+            return program;
+        }
+        qDebug() << "Program binary of" << path << "rejected, compiling";
+        _binaries.remove(key);
+        delete program;
+    }
+
+    QGLShaderProgram *program = new QGLShaderProgram;
+    program->addShaderFromSourceCode(QGLShader::Vertex, vertexSource);
+    program->addShaderFromSourceCode(QGLShader::Fragment, fragmentSource);
+    program->bindAttributeLocation("vertex", 0);
+    if (binaries) {
+        gl->glProgramParameteri(program->programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    if (!program->link()) {
+        qDebug() << "Shader" << path << ":" << program->log();
+        delete program;
+        return NULL;
+    }
+    ++_compiled;
+
+    if (binaries) {
+        GLint length = 0;
+        gl->glGetProgramiv(program->programId(), GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length > 0) {
+            binary.data.resize(length);
+            gl->glGetProgramBinary(program->programId(), length, NULL, &binary.format, binary.data.data());
+            storeBinary(key, binary);
+        }
+    }
+    return program;
+}
+
+bool GLShaderManager::loadBinary(const QByteArray &key, Binary *binary){
+    QHash<QByteArray, Binary>::const_iterator i = _binaries.constFind(key);
+    if (i != _binaries.constEnd()) {
+        *binary = i.value();
+        return true;
+    }
+
+    QFile file(_cacheDir + "/" + key + ".bin");
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QDataStream in(&file);
+    quint32 format;
+    in >> format >> binary->data;
+    if (in.status() != QDataStream::Ok || binary->data.isEmpty()) return false;
+    binary->format = format;
+    _binaries.insert(key, *binary);
+    return true;
+}
+
+void GLShaderManager::storeBinary(const QByteArray &key, const Binary &binary){
+    _binaries.insert(key, binary);
+
+    if (!QDir().mkpath(_cacheDir)) return;
+    QSaveFile file(_cacheDir + "/" + key + ".bin");
+    if (!file.open(QIODevice::WriteOnly)) return;
+    QDataStream out(&file);
+    out << quint32(binary.format) << binary.data;
+    if (!file.commit()) {
+        qDebug() << "Cannot write program binary" << file.fileName();
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef GLSHADERMANAGER_H
+#define GLSHADERMANAGER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QGLShaderProgram>
+
+class QOpenGLContext;
+
+// Owns the shader programs of every GL context in the process. A program
+// is a pair of files, path.vsh and path.fsh, linked once per context; and
+// where the driver can hand out program binaries (GL_ARB_get_program_binary,
+// OpenGL 4.1, ES 3.0) it is compiled only once per process and driver: the
+// binary is kept in memory and in a cache directory, keyed by a hash of
+// both sources and the driver's vendor, renderer and version strings, and
+// later contexts load it instead of compiling. A binary the driver rejects
+// falls back to compiling the sources.
+//
+// Attribute "vertex" is always bound to location 0, compatibility contexts
+// need a per-vertex array there.
+class GLShaderManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    static GLShaderManager* instance();
+
+    // Directory of the program binaries, in the application's cache
+    // location unless set.
+    void setCacheDir(const QString &dir) { _cacheDir = dir; }
+
+    // Program of the current context from path.vsh and path.fsh, linked
+    // on first use. NULL if it does not compile.
+    QGLShaderProgram* program(const QString &path);
+
+    // Link every program in dir for the current context, so later ones
+    // come from the binary cache.
+    void preload(const QString &dir);
+
+    // Programs compiled from source and loaded from a binary so far.
+    int compiled() const     { return _compiled; }
+    int binaryLoads() const  { return _binaryLoads; }
+
+private slots:
+    void contextDestroyed();
+
+private:
+    struct Binary {
+        GLenum     format;
+        QByteArray data;
+    };
+
+    GLShaderManager();
+    ~GLShaderManager();
+
+    QGLShaderProgram* link(const QString &path);
+    bool binariesSupported();
+    bool loadBinary(const QByteArray &key, Binary *binary);
+    void storeBinary(const QByteArray &key, const Binary &binary);
+
+    QString _cacheDir;
+    QHash<QOpenGLContext*, QHash<QString, QGLShaderProgram*> > _programs;
+    QHash<QByteArray, Binary> _binaries;
+    int _compiled;
+    int _binaryLoads;
+};
+
+#endif // GLSHADERMANAGER_H
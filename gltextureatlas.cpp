@@ -0,0 +1,257 @@
+#include "gltextureatlas.h"
+#include <QDir>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Mip levels of a page after the base one. Images are padded and placed
+// in multiples of 1 << MipLevels texels, so every level keeps at least
+// one texel of gutter and sampling a smaller level does not blend in the
+// neighbours.
+const int MipLevels = 2;
+const int Padding = 1 << MipLevels;
+
+int alignedSize(int size) {
+    return (size + Padding - 1) / Padding * Padding;
+}
+
+GLAtlasRegion noRegion(){
+    GLAtlasRegion none;
+    none.texture = 0;
+    none.rect = QVector4D(0, 0, 1, 1);
+    none.translucent = false;
+    return none;
+}
+
+bool tallerFirst(const DecodedImage &a, const DecodedImage &b) {
+    return a.image.height() > b.image.height();
+}
+
+}
+
+GLTextureAtlas::GLTextureAtlas() :
+    _pageSize(0),
+    _placeholder(noRegion())
+{
+}
+
+GLTextureAtlas::~GLTextureAtlas()
+{
+    clear();
+}
+
+void GLTextureAtlas::clear(){
+    for (int i = 0; i < _pages.size(); ++i) {
+        glDeleteTextures(1, &_pages[i].texture);
+    }
+    _pages.clear();
+    _regions.clear();
+
+    // Drop what is still being decoded.
+    _loader.waitForDone();
+    _loader.takeDecoded();
+    _loading.clear();
+    _ready.clear();
+}
+
+void GLTextureAtlas::build(const QString &dir){
+    clear();
+    _dir = dir;
+
+    GLint maxSize = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+    _pageSize = qMin(2048, int(maxSize));
+
+    // Drawn while images load: opaque white, tinted by the item color.
+    QImage placeholder(4, 4, QImage::Format_RGBA8888);
+    placeholder.fill(Qt::white);
+    _placeholder = insert(placeholder, false);
+    generateMipmaps();
+
+    QStringList filters;
+    filters << "*.png" << "*.jpg" << "*.jpeg" << "*.bmp";
+    foreach (const QString &name, QDir(dir).entryList(filters, QDir::Files)) {
+        region(name);
+    }
+}
+
+void GLTextureAtlas::update(qint64 budget){
+    if (_loading.isEmpty()) return;
+
+    _ready += _loader.takeDecoded();
+    if (_ready.isEmpty()) return;
+
+    // Tallest first keeps the shelves tight.
+    std::stable_sort(_ready.begin(), _ready.end(), tallerFirst);
+
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        const DecodedImage decoded = _ready.takeFirst();
+        _loading.remove(decoded.name);
+        if (decoded.image.isNull()) {
+            _regions.insert(decoded.name, noRegion());
+        } else {
+            _regions.insert(decoded.name, insert(decoded.image, decoded.translucent));
+        }
+    } while (!_ready.isEmpty() && timer.nsecsElapsed() < budget);
+    generateMipmaps();
+
+    if (_loading.isEmpty()) {
+        // Compare a first start with a later one to see what the texture
+        // cache saves.
+        qDebug() << "Texture atlas:" << _regions.size() << "images in" << pageCount()
+                 << "pages," << qRound(occupancy() * 100) << "% used, loaded in"
+                 << _loadTimer.elapsed() << "ms";
+    }
+}
+
+void GLTextureAtlas::finishLoading(){
+    if (_loading.isEmpty()) return;
+    _loader.waitForDone();
+    update(std::numeric_limits<qint64>::max());
+}
+
+bool GLTextureAtlas::findRegion(const QString &name, GLAtlasRegion *region) const {
+    if (name.isNull()) {
+        *region = noRegion();
+        return true;
+    }
+    QHash<QString,GLAtlasRegion>::const_iterator i = _regions.constFind(name);
+    if (i == _regions.constEnd()) return false;
+    *region = i.value();
+    return true;
+}
+
+GLAtlasRegion GLTextureAtlas::region(const QString &name){
+    GLAtlasRegion region;
+    if (findRegion(name, &region)) return region;
+
+    qDebug() << "Loading texture: " << name;
+    if (_loading.isEmpty()) _loadTimer.start();
+    _loading.insert(name);
+    _regions.insert(name, _placeholder);
+    _loader.request(name, _dir + name);
+    return _placeholder;
+}
+
+bool GLTextureAtlas::place(Page &page, const QSize &size, QPoint *position){
+    int shelfY = page.shelfY;
+    int shelfHeight = page.shelfHeight;
+    int cursorX = page.cursorX;
+    if (cursorX + size.width() > page.width) {
+        // Next shelf.
+        shelfY += shelfHeight;
+        shelfHeight = 0;
+        cursorX = 0;
+    }
+    if (size.width() > page.width || shelfY + size.height() > page.height) {
+        return false;
+    }
+
+    *position = QPoint(cursorX, shelfY);
+    page.shelfY = shelfY;
+    page.cursorX = cursorX + size.width();
+    page.shelfHeight = qMax(shelfHeight, size.height());
+    page.usedArea += qint64(size.width()) * size.height();
+    return true;
+}
+
+GLAtlasRegion GLTextureAtlas::insert(const QImage &image, bool translucent){
+    const QSize padded(alignedSize(image.width() + 2 * Padding), alignedSize(image.height() + 2 * Padding));
+
+    QPoint position;
+    int pageIndex = -1;
+    for (int i = 0; i < _pages.size() && pageIndex < 0; ++i) {
+        if (place(_pages[i], padded, &position)) pageIndex = i;
+    }
+
+    if (pageIndex < 0) {
+        // New page, as large as the image if it does not fit a normal one.
+        Page page;
+        page.width = qMax(_pageSize, padded.width());
+        page.height = qMax(_pageSize, padded.height());
+        page.shelfY = 0;
+        page.shelfHeight = 0;
+        page.cursorX = 0;
+        page.usedArea = 0;
+        page.mipmapsDirty = true;
+
+        glGenTextures(1, &page.texture);
+        glBindTexture(GL_TEXTURE_2D, page.texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, MipLevels);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        // Only the padded blocks are ever sampled, the rest stays undefined.
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, page.width, page.height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+        _pages.append(page);
+        pageIndex = _pages.size() - 1;
+        place(_pages[pageIndex], padded, &position);
+    }
+
+    Page &page = _pages[pageIndex];
+    const int x = position.x() + Padding;
+    const int y = position.y() + Padding;
+    const int w = image.width();
+    const int h = image.height();
+    // The image with its edge texels repeated into the whole padded
+    // block, corners included, as GL_CLAMP_TO_EDGE would sample it. Rows
+    // are copied as they are, the image is in the pages' layout already,
+    // so this copy is the only one between the cache mapping and GL.
+    _block.resize(padded.width() * padded.height());
+    for (int row = 0; row < padded.height(); ++row) {
+        const quint32 *source = reinterpret_cast<const quint32*>(image.constScanLine(qBound(0, row - Padding, h - 1)));
+        quint32 *target = _block.data() + row * padded.width();
+        for (int column = 0; column < Padding; ++column) {
+            target[column] = source[0];
+        }
+        memcpy(target + Padding, source, w * sizeof(quint32));
+        for (int column = Padding + w; column < padded.width(); ++column) {
+            target[column] = source[w - 1];
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, page.texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, position.x(), position.y(), padded.width(), padded.height(),
+                    GL_RGBA, GL_UNSIGNED_BYTE, _block.constData());
+    page.mipmapsDirty = true;
+
+    // Images and pages are bottom row first, so the shelves stack up
+    // from t = 0 and item coordinates keep v = 0 at the bottom.
+    const float pageWidth = page.width;
+    const float pageHeight = page.height;
+    GLAtlasRegion region;
+    region.texture = page.texture;
+    region.rect = QVector4D(x / pageWidth, y / pageHeight, w / pageWidth, h / pageHeight);
+    region.translucent = translucent;
+    return region;
+}
+
+void GLTextureAtlas::generateMipmaps(){
+    // Once per page and frame however many images went in.
+    QOpenGLFunctions *gl = QOpenGLContext::currentContext()->functions();
+    for (int i = 0; i < _pages.size(); ++i) {
+        Page &page = _pages[i];
+        if (!page.mipmapsDirty) continue;
+        glBindTexture(GL_TEXTURE_2D, page.texture);
+        gl->glGenerateMipmap(GL_TEXTURE_2D);
+        page.mipmapsDirty = false;
+    }
+}
+
+float GLTextureAtlas::occupancy() const {
+    qint64 used = 0, total = 0;
+    foreach (const Page &page, _pages) {
+        used += page.usedArea;
+        total += qint64(page.width) * page.height;
+    }
+    return total > 0 ? float(used) / total : 0.0f;
+}
@@ -0,0 +1,99 @@
+#ifndef GLTEXTUREATLAS_H
+#define GLTEXTUREATLAS_H
+
+#include <QGLWidget>
+#include <QHash>
+#include <QElapsedTimer>
+#include <QImage>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QVector4D>
+#include "textureloader.h"
+
+// Where a texture ended up: the atlas page and the part of it, as
+// (s, t, width, height) in texture coordinates. Item coordinates in [0, 1]
+// map to s + u * width, t + v * height. Translucent regions have pixels
+// that are not fully opaque and need blending.
+struct GLAtlasRegion {
+    GLuint    texture;
+    QVector4D rect;
+    bool      translucent;
+};
+
+// Packs textures into a few large pages so items with different textures
+// can share a draw. Images are decoded on a TextureLoader's threads and
+// packed and uploaded by update() on the GL thread, a few per frame, while
+// items whose image is not there yet draw with a small placeholder. Images
+// are padded with a copy of their edge pixels so linear filtering does not
+// pick up the neighbours, at the base level and at the pages' mip levels,
+// which are generated again after each update() that packed images.
+class GLTextureAtlas
+{
+public:
+    GLTextureAtlas();
+    ~GLTextureAtlas();
+
+    // Start loading every image in dir. The GL context must be current,
+    // here and in region() and update().
+    void build(const QString &dir);
+
+    // Region of the named image in dir. An image not asked for before is
+    // requested, until update() has uploaded it the placeholder is drawn
+    // instead. A null name or an unreadable image gives texture 0.
+    GLAtlasRegion region(const QString &name);
+
+    // Pack and upload decoded images for about budget ns, at least one;
+    // the rest waits for the next call. Call once per frame.
+    void update(qint64 budget);
+
+    // Wait for every requested image and upload it.
+    void finishLoading();
+
+    // Images requested and not uploaded yet.
+    int loading() const { return _loading.size(); }
+
+    // Region of an image that is already loaded, false if region() still
+    // has to load it. Only reads, so threads may call it together while
+    // nothing is loaded.
+    bool findRegion(const QString &name, GLAtlasRegion *region) const;
+
+    int   pageCount() const { return _pages.size(); }
+    // Fraction of the page area covered by images, padding included.
+    float occupancy() const;
+
+    // Delete the pages.
+    void clear();
+
+private:
+    // Shelves are filled from the bottom row up, the pages' GL layout.
+    struct Page {
+        GLuint  texture;
+        int     width;
+        int     height;
+        int     shelfY;         // bottom of the current shelf
+        int     shelfHeight;
+        int     cursorX;
+        qint64  usedArea;
+        bool    mipmapsDirty;   // images went in since the mips were built
+    };
+
+    bool place(Page &page, const QSize &size, QPoint *position);
+    // image is RGBA8888 bottom row first, what the TextureLoader gives.
+    GLAtlasRegion insert(const QImage &image, bool translucent);
+    void generateMipmaps();
+
+    QString                      _dir;
+    int                          _pageSize;
+    QList<Page>                  _pages;
+    QHash<QString,GLAtlasRegion> _regions;
+    GLAtlasRegion                _placeholder;
+    TextureLoader                _loader;
+    QSet<QString>                _loading;
+    QList<DecodedImage>          _ready;     // decoded, waiting for upload
+    QElapsedTimer                _loadTimer; // since the last time nothing was loading
+    QVector<quint32>             _block;     // padded image being uploaded
+};
+
+#endif // GLTEXTUREATLAS_H
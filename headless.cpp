@@ -0,0 +1,156 @@
+#include "headless.h"
+#include "worlds.h"
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QVector>
+#include <algorithm>
+#include <cstdio>
+
+HeadlessRunner::HeadlessRunner(QObject *parent) :
+    QObject(parent),
+    _worldName("arcanoid"),
+    _seconds(60.0),
+    _rate(0.0),
+    _gameFinished(false)
+{
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+}
+
+QBox2DWorld* createWorld(const QString &name, QObject *parent){
+    QBox2DWorld *world = NULL;
+    if (name == "arcanoid") {
+        world = new ArcanoidWorld(parent);
+    } else if (name == "example") {
+        world = new ExampleWorld(parent);
+    } else if (name == "test") {
+        world = new TestWorld(parent);
+    } else {
+        return NULL;
+    }
+
+    // Same settings as MainWindow::createWorld.
+    world->setSettings(1.0f / PHYSICS_RATE, 10, 10);
+    world->_levels_dir = LEVELS_DIR;
+    return world;
+}
+
+QBox2DWorld* HeadlessRunner::createWorld(){
+    QBox2DWorld *world = ::createWorld(_worldName, this);
+    if (!world) return NULL;
+    connect(world, SIGNAL(gameFinished()), this, SLOT(finishGame()));
+    world->populate();
+    return world;
+}
+
+void HeadlessRunner::finishGame(){
+    _gameFinished = true;
+}
+
+int HeadlessRunner::run(){
+    QBox2DWorld *world = createWorld();
+    if (!world) {
+        fprintf(stderr, "Unknown world: %s\n", qPrintable(_worldName));
+        return 1;
+    }
+
+    const double timeStep = world->timeStep();
+    const qint64 steps = qMax<qint64>(1, qint64(_seconds / timeStep + 0.5));
+    const qint64 period = _rate > 0.0 ? qint64(1.0e9 / _rate) : 0;
+
+    QVector<qint64> stepTimes;
+    stepTimes.reserve(steps);
+    double box2dStepMs = 0.0;
+    int games = 1;
+    int bodies = 0;
+
+    QElapsedTimer wallTimer;
+    wallTimer.start();
+    QElapsedTimer stepTimer;
+
+    for (qint64 i = 0; i < steps; ++i) {
+        if (_gameFinished) {
+            // The world emitted gameFinished from inside step(), replace it
+            // now that it is no longer on the stack.
+            delete world;
+            _gameFinished = false;
+            world = createWorld();
+            ++games;
+        }
+
+        if (period > 0) {
+            qint64 wait = i * period - wallTimer.nsecsElapsed();
+            if (wait > 0) {
+                QThread::usleep(wait / 1000);
+            }
+        }
+
+        stepTimer.start();
+        world->step();
+        stepTimes.append(stepTimer.nsecsElapsed());
+        box2dStepMs += world->_world->GetProfile().step;
+        bodies = qMax(bodies, world->_world->GetBodyCount());
+    }
+
+    const double wallSeconds = wallTimer.nsecsElapsed() * 1.0e-9;
+    const double simulatedSeconds = steps * timeStep;
+    delete world;
+
+    qint64 total = 0;
+    foreach (qint64 t, stepTimes) {
+        total += t;
+    }
+    std::sort(stepTimes.begin(), stepTimes.end());
+    const int n = stepTimes.size();
+    const double mean = total * 1.0e-6 / n;
+    const double p50 = stepTimes.at((n - 1) / 2) * 1.0e-6;
+    const double p99 = stepTimes.at(qMin(n - 1, (99 * n + 99) / 100 - 1)) * 1.0e-6;
+    const double max = stepTimes.last() * 1.0e-6;
+
+    printf("world             %s\n", qPrintable(_worldName));
+    printf("mode              %s\n", period > 0 ? qPrintable(QString("fixed %1 Hz").arg(_rate)) : "as fast as possible");
+    printf("steps             %lld (%d game%s, up to %d bodies)\n", steps, games, games > 1 ? "s" : "", bodies);
+    printf("simulated time    %.3f s\n", simulatedSeconds);
+    printf("wall time         %.3f s\n", wallSeconds);
+    printf("throughput        %.1f steps/s, %.2fx real time\n", steps / wallSeconds, simulatedSeconds / wallSeconds);
+    printf("step time         mean %.4f ms, p50 %.4f ms, p99 %.4f ms, max %.4f ms\n", mean, p50, p99, max);
+    printf("b2World::Step     mean %.4f ms\n", box2dStepMs / n);
+    return 0;
+}
+
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message){
+    Q_UNUSED(context);
+    if (type != QtDebugMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+    }
+}
+
+int runHeadless(const QStringList &arguments){
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Steps a game world without rendering and prints timing statistics.");
+    parser.addHelpOption();
+    QCommandLineOption headlessOption("headless", "Run without window, GL and sound.");
+    QCommandLineOption worldOption("world", "World to run: arcanoid, example or test.", "name", "arcanoid");
+    QCommandLineOption secondsOption("seconds", "Simulated time to run.", "seconds", "60");
+    QCommandLineOption rateOption("rate", "Steps per wall clock second, 0 steps as fast as possible.", "hz", "0");
+    QCommandLineOption verboseOption("verbose", "Keep the debug output of the worlds.");
+    parser.addOption(headlessOption);
+    parser.addOption(worldOption);
+    parser.addOption(secondsOption);
+    parser.addOption(rateOption);
+    parser.addOption(verboseOption);
+    parser.process(arguments);
+
+    if (!parser.isSet(verboseOption)) {
+        qInstallMessageHandler(quietMessageHandler);
+    }
+
+    HeadlessRunner runner;
+    runner.setWorld(parser.value(worldOption));
+    runner.setSeconds(parser.value(secondsOption).toDouble());
+    runner.setRate(parser.value(rateOption).toDouble());
+    return runner.run();
+}
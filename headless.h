@@ -0,0 +1,50 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <QObject>
+#include <QStringList>
+
+class QBox2DWorld;
+
+// Runs a game world without any window, GL context or sound. Worlds are
+// stepped back to back, or paced to a wall clock rate, until the requested
+// amount of simulated time has passed; the world is rebuilt whenever its
+// game finishes. Throughput and step time statistics go to stdout.
+class HeadlessRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessRunner(QObject *parent = 0);
+    ~HeadlessRunner();
+
+    void setWorld(const QString &name)  { _worldName = name; }
+    void setSeconds(double seconds)     { _seconds = seconds; }
+    void setRate(double stepsPerSecond) { _rate = stepsPerSecond; }
+
+    // Returns the process exit code.
+    int run();
+
+private slots:
+    void finishGame();
+
+private:
+    QBox2DWorld* createWorld();
+
+    QString      _worldName;
+    double       _seconds;
+    double       _rate;
+    bool         _gameFinished;
+};
+
+// Parses the command line of a headless run and runs it.
+int runHeadless(const QStringList &arguments);
+
+// Message handler that drops qDebug output, the worlds are chatty.
+void quietMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+
+// New unpopulated world by name: arcanoid, example or test. NULL for an
+// unknown name.
+QBox2DWorld* createWorld(const QString &name, QObject *parent);
+
+#endif // HEADLESS_H
@@ -0,0 +1,45 @@
+# Game worlds without window, OpenGL or sound, for machines with no display.
+# Build Box2D/Box2D.pro first. Run from this directory like qbox2d, e.g.
+#   ./qbox2d-headless --world arcanoid --seconds 600
+QT       = core gui xml
+
+CONFIG   += console release warn_on
+CONFIG   -= app_bundle
+
+# Must match Box2D/Box2D.pro.
+#DEFINES += B2_TRACE
+
+DEFINES  += QBOX2D_HEADLESS_ONLY
+
+TARGET = qbox2d-headless
+TEMPLATE = app
+
+SOURCES += ../main.cpp \
+           ../headless.cpp \
+           ../items.cpp \
+           ../world.cpp \
+           ../worlds/testworld.cpp \
+           ../worlds/exampleworld.cpp \
+           ../worlds/arcanoidworld.cpp \
+           ../physicitem.cpp \
+           ../contactlistener.cpp \
+           ../brick.cpp
+
+HEADERS += ../headless.h \
+           ../items.h \
+           ../def.h \
+           ../world.h \
+           ../worlds/worlds.h \
+           ../worlds/testworld.h \
+           ../worlds/exampleworld.h \
+           ../worlds/arcanoidworld.h \
+           ../physicitem.h \
+           ../contactlistener.h \
+           ../brick.h
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+
+INCLUDEPATH += .. ../Box2D ../worlds
+QMAKE_LIBDIR += $$PWD/../Box2D/lib
+LIBS += -lBox2D
@@ -1,81 +1,92 @@
 #include "items.h"
-#include "glscene.h"
-
-QBox2DItem::QBox2DItem():
-    _graphics(NULL),
-    _glmode(GL_QUADS)
-{
-    _textureCoordinates << QVector2D(0, 1) << QVector2D(0, 0) << QVector2D(1, 0) << QVector2D(1, 1);
-}
-
-void QBox2DItem::update(){
-    if(!body()) return;
-    const b2Shape *shape = body()->GetFixtureList()->GetShape();
-    if (!shape) return;
-    _vertices.clear();
-    if( shape->GetType() == b2Shape::e_polygon ) {
-           for (int32 i = 0; i < ((b2PolygonShape*)shape)->GetVertexCount(); ++i){
-               const b2Vec2 vertex = ((b2PolygonShape*)shape)->GetVertex(i);
-               _vertices.append(QVector3D(vertex.x, vertex.y, 0));
-           }
-       } else if (shape->GetType() == b2Shape::e_circle ) {
+#include <QByteArray>
+#include <QHash>
+
+namespace {
+
+// Local-space outline of a shape. Circles are drawn as a textured quad.
+QVector<QVector3D> buildGeometry(const b2Shape *shape) {
+    QVector<QVector3D> vertices;
+    if (shape->GetType() == b2Shape::e_polygon) {
+        const b2PolygonShape *polygon = static_cast<const b2PolygonShape*>(shape);
+        vertices.reserve(polygon->GetVertexCount());
+        for (int32 i = 0; i < polygon->GetVertexCount(); ++i) {
+            const b2Vec2 vertex = polygon->GetVertex(i);
+            vertices.append(QVector3D(vertex.x, vertex.y, 0));
+        }
+    } else if (shape->GetType() == b2Shape::e_circle) {
         float32 radius = shape->m_radius;
-        /*
-           _vertices.append(QVector3D(0, 0, -2));
-           int accuracy = 32;
-
-           float32 a = 2 * PI/accuracy;
-           for(int i = 0; i < accuracy; ++i) {
-               _vertices.append(QVector3D(cos(a*i) * radius, sin(a*i) * radius, -2));
-           }
-           _vertices.append(QVector3D(radius, 0, -2));
-           */
-        _vertices.append(QVector3D( -radius, -radius, 0 ));
-        _vertices.append(QVector3D( -radius,  radius, 0 ));
-        _vertices.append(QVector3D(  radius,  radius, 0 ));
-        _vertices.append(QVector3D(  radius, -radius, 0 ));
-       }
-
-    _mMatrix.setToIdentity();
-    _mMatrix.translate(position().x,position().y,0);
-    _mMatrix.rotate(RAD2ANG(rotation()), QVector3D(0,0,1));
+        vertices << QVector3D( -radius, -radius, 0 )
+                 << QVector3D( -radius,  radius, 0 )
+                 << QVector3D(  radius,  radius, 0 )
+                 << QVector3D(  radius, -radius, 0 );
+    }
+    return vertices;
+}
+
+// Items with identical shapes share one outline, keyed by the shape type
+// and the numbers buildGeometry reads. Items are created on the thread
+// that runs the world, one world at a time.
+QVector<QVector3D> sharedGeometry(const b2Shape *shape) {
+    static QHash<QByteArray, QVector<QVector3D> > cache;
+
+    QByteArray key;
+    key.append(char(shape->GetType()));
+    if (shape->GetType() == b2Shape::e_polygon) {
+        const b2PolygonShape *polygon = static_cast<const b2PolygonShape*>(shape);
+        key.append(reinterpret_cast<const char*>(polygon->m_vertices),
+                   int(polygon->GetVertexCount() * sizeof(b2Vec2)));
+    } else {
+        key.append(reinterpret_cast<const char*>(&shape->m_radius), int(sizeof(float32)));
+    }
 
-    if(!graphics()) return;
-    graphics()->setPos(position().x,position().y);
-    graphics()->setRotation(RAD2ANG(rotation()));
+    QHash<QByteArray, QVector<QVector3D> >::const_iterator it = cache.constFind(key);
+    if (it != cache.constEnd()) return it.value();
+    return cache.insert(key, buildGeometry(shape)).value();
 }
 
-void QBox2DItem::draw(){
-    //glDisable(GL_DEPTH_TEST);
-    QGLShaderProgram* shader = _glscene->shader();
-    shader->bind();
-    shader->setUniformValue("viewMatrix", _glscene->camera().viewMatrix());
-    shader->setUniformValue("projMatrix", _glscene->camera().projMatrix());
+const QVector<QVector2D>& defaultTextureCoordinates() {
+    static const QVector<QVector2D> coordinates = QVector<QVector2D>()
+            << QVector2D(0, 1) << QVector2D(0, 0) << QVector2D(1, 0) << QVector2D(1, 1);
+    return coordinates;
+}
 
-    shader->setUniformValue("modelMatrix", modelMatrix());
-    shader->setUniformValue("color", color());
+}
 
-    shader->setAttributeArray("vertex", vertices().constData());
-    shader->enableAttributeArray("vertex");
+QBox2DItem::QBox2DItem() :
+    _textureCoordinates(defaultTextureCoordinates()),
+    _appendIndex(0),
+    _visibleFrame(0)
+{
+}
 
-    shader->setAttributeArray("textureCoordinate", _textureCoordinates.constData());
-    shader->enableAttributeArray("textureCoordinate");
+void QBox2DItem::update(){
+    // Geometry is fixed once the body has its shape, a step only moves
+    // the item and the renderer reads the pose from the body.
+    storePreviousTransform();
+}
 
-    GLuint texID = _glscene->textures().value(textureName());
-    shader->setUniformValue("texture", 0);
-    glBindTexture(GL_TEXTURE_2D, texID);
+void QBox2DItem::shapeChanged(){
+    const b2Fixture *fixture = body() ? body()->GetFixtureList() : NULL;
+    if (!fixture) return;
+    _vertices = sharedGeometry(fixture->GetShape());
+}
 
-    glDrawArrays(_glmode, 0, vertices().size());
-    shader->disableAttributeArray("vertex");
-    shader->disableAttributeArray("textureCoordinate");
-    shader->release();
+void QBox2DItem::storeState(){
+    PhysicItem::storeState();
+    _storedColor = _color;
+    _storedMatrix = _mMatrix;
+    _storedTextureName = _textureName;
 }
 
-QAbstractGraphicsShapeItem* QBox2DItem::graphics() const {
-    return _graphics;
+void QBox2DItem::restoreState(){
+    PhysicItem::restoreState();
+    _color = _storedColor;
+    _mMatrix = _storedMatrix;
+    _textureName = _storedTextureName;
 }
 
-QVector<QVector3D>          QBox2DItem::vertices() const {
+const QVector<QVector3D>&   QBox2DItem::vertices() const {
     return _vertices;
 }
 
@@ -91,28 +102,24 @@ const QString QBox2DItem::textureName() const {
     return _textureName;
 }
 
-
-GLuint QBox2DItem::textureID() const {
-    return _textureID;
-}
-
 QMatrix4x4& QBox2DItem::modelMatrix() {
     return _mMatrix;
 }
 
 
-void QBox2DItem::setGraphics(QAbstractGraphicsShapeItem* gi) {
-    if(_graphics) {
-        delete _graphics;
-    }
-    _graphics = gi;
+QMatrix4x4 RenderItem::interpolatedMatrix(float32 alpha) const {
+    if (!hasBody) return modelMatrix;
+
+    b2Vec2  p = (1.0f - alpha) * previousPosition + alpha * position;
+    float32 a = (1.0f - alpha) * previousRotation + alpha * rotation;
+    QMatrix4x4 m;
+    m.translate(p.x, p.y, 0);
+    m.rotate(RAD2ANG(a), QVector3D(0,0,1));
+    return m;
 }
 
 void QBox2DItem::setColor(const QColor &c) {
     _color = c;
-    if (graphics()) {
-        graphics()->setBrush(c);
-    }
 }
 
 void QBox2DItem::setName(const QString &name){
@@ -132,15 +139,3 @@ void QBox2DItem::setVertices(const QVector<QVector3D> &vertices){
     _vertices.clear();
     _vertices = vertices;
 }
-
-void QBox2DItem::setTextureID(const GLuint &textureID){
-    _textureID = textureID;
-}
-
-void QBox2DItem::setGLmode(const GLenum &mode){
-    _glmode = mode;
-}
-
-GLenum QBox2DItem::GLmode() const {
-    return _glmode;
-}
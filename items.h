@@ -1,55 +1,94 @@
 #ifndef ITEMS_H
 #define ITEMS_H
 
-#include <QAbstractGraphicsShapeItem>
-#include <QBrush>
-#include <QtOpenGL>
+#include <QColor>
+#include <QMatrix4x4>
+#include <QString>
+#include <QVector>
+#include <QVector2D>
+#include <QVector3D>
 #include "def.h"
 #include "physicitem.h"
 
-class GLScene;
-
+// Game object: a Box2D body plus what a renderer needs to draw it. Nothing
+// here depends on OpenGL or QtWidgets, drawing lives in GLScene, so worlds
+// also run headless.
 class QBox2DItem : public PhysicItem {
 public:
 
     QBox2DItem();
-    virtual ~QBox2DItem() { if(_graphics) delete _graphics; }
+    virtual ~QBox2DItem() {}
 
     virtual int handleContact();
 
-    void setGraphics(QAbstractGraphicsShapeItem* gi);
     void setColor(const QColor &c);
     void setName(const QString &name);
     void update();
-    void draw();
     void setVertices(const QVector<QVector3D> &vertices);
     void setTextureName(const QString &textureName);
-    void setTextureID(const GLuint &textureID);
-    void setGLmode(const GLenum &mode);
 
-    QAbstractGraphicsShapeItem* graphics()    const;
-    QVector<QVector3D>          vertices()    const;
-    QMatrix4x4&                 modelMatrix();
+    const QVector<QVector3D>&   vertices()    const;
+    QMatrix4x4&                 modelMatrix();  // placement of items without a body
     const QColor                color()       const;
     const QString               name()        const;
     const QString               textureName() const;
-          GLuint                textureID()   const;
-          GLenum                GLmode()      const;
 
-    GLScene*           _glscene;
     QVector<QVector2D> _textureCoordinates;
 
+    // Kept by QBox2DWorld: the order the item was appended in, and the
+    // last snapshot whose view query reported it.
+    int _appendIndex;
+    int _visibleFrame;
+
+    void storeState();
+    void restoreState();
+
+protected:
+    void shapeChanged();
+
 private:
-    QAbstractGraphicsShapeItem* _graphics;
     QColor             _color;
     QString            _name;
     QMatrix4x4         _mMatrix;
     QString            _textureName;
-    GLuint             _textureID;
     QVector<QVector3D> _vertices;
-    GLenum             _glmode;
+
+    // What the game changes, for restoreState.
+    QColor             _storedColor;
+    QMatrix4x4         _storedMatrix;
+    QString            _storedTextureName;
 
 };
 
+// Copy of what a renderer needs from an item, taken by the physics thread
+// after a step. The Qt containers are implicitly shared, so a copy costs a
+// reference count until the item changes them.
+struct RenderItem {
+    QMatrix4x4         modelMatrix;     // as set by the world, used without a body
+    QColor             color;
+    QString            textureName;
+    QVector<QVector3D> vertices;
+    QVector<QVector2D> textureCoordinates;
+    bool               hasBody;
+    b2Vec2             previousPosition;
+    b2Vec2             position;
+    float32            previousRotation;
+    float32            rotation;
+
+    // Model matrix of the body pose at alpha between the pose before the
+    // last step (0) and after it (1).
+    QMatrix4x4 interpolatedMatrix(float32 alpha) const;
+};
+
+// The items of a world a renderer should draw, see QBox2DWorld::snapshot.
+struct WorldSnapshot {
+    WorldSnapshot() : step(0), time(0), timeStep(0), culled(0) {}
+
+    QVector<RenderItem> items;
+    qint64              step;
+    qint64              time;       // clock time the current poses belong to, in ns
+    qint64              timeStep;   // ns between previous and current poses
+    int                 culled;     // items left out as outside the view
+};
 
 #endif // ITEMS_H
@@ -1,14 +1,54 @@
+#if !defined(QBOX2D_HEADLESS_ONLY)
 #include <QtWidgets/QApplication>
+#include <QGuiApplication>
 #include "mainwindow.h"
+#include "capture.h"
+#endif
+#include <QCoreApplication>
+#include "headless.h"
+#include <Box2D.h>
+#include <cstring>
 #include <time.h>
 
 int main(int argc, char *argv[])
 {
+    // Headless runs must not touch the window system, check before any
+    // application object exists.
+    bool headless = false;
+    bool capture = false;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0)
+            headless = true;
+        if (strncmp(argv[i], "--capture", 9) == 0)
+            capture = true;
+    }
+#if defined(QBOX2D_HEADLESS_ONLY)
+    headless = true;
+#endif
+
+    qsrand(time(0));
+    b2TraceSetThreadName("main");
+    b2TraceExportOnExit("qbox2d-trace.json");
+
+    if (headless) {
+        QCoreApplication a(argc, argv);
+        a.setApplicationName("QBox2D");
+        return runHeadless(a.arguments());
+    }
+
+#if !defined(QBOX2D_HEADLESS_ONLY)
+    if (capture) {
+        // GL through an offscreen surface, no widgets.
+        QGuiApplication a(argc, argv);
+        a.setApplicationName("QBox2D");
+        return runCapture(a.arguments());
+    }
+
     QApplication a(argc, argv);
     a.setApplicationName("QBox2D");
-    qsrand(time(0));
     MainWindow w;
     w.show();
 
     return a.exec();
+#endif
 }
@@ -1,16 +1,19 @@
 #include "mainwindow.h"
-#include "qscene.h"
-#include "view.h"
 #include "worlds.h"
 #include "glscene.h"
+#include "physicsthread.h"
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    glscene(NULL),
+    world(NULL),
+    physics(NULL)
 {
     ui->setupUi(this);
     timer = new QTimer(this);
-    timer->setInterval(1000/60);
+    timer->setInterval(1000/RENDER_RATE);
     QString sounds_dir = SOUNDS_DIR;
     sound = new QSound(sounds_dir + "pop.wav",this);
     sound->play();
@@ -20,6 +23,13 @@ MainWindow::MainWindow(QWidget *parent) :
     player->setVolume(90);
     player->play();
 
+#if defined(B2_TRACE)
+    QAction *traceAction = new QAction(this);
+    traceAction->setShortcut(Qt::Key_F12);
+    addAction(traceAction);
+    connect(traceAction, SIGNAL(triggered()), this, SLOT(saveTrace()));
+#endif
+
     startGame();
 }
 
@@ -30,71 +40,49 @@ void MainWindow::createGLScene(){
     glscene->_texture_dir = TEXTURE_DIR;
     ui->frameL->layout()->addWidget(glscene);
 
-    connect(timer,SIGNAL(timeout()),glscene,SLOT(updateGL()));
-
     connect(ui->actionZoomIn,  SIGNAL(triggered()), glscene, SLOT(zoomIn()));
     connect(ui->actionZoomOut, SIGNAL(triggered()), glscene, SLOT(zoomOut()));
 
-    connect(glscene,SIGNAL(mouseLeftButtonPressed(QPointF)), world,SLOT(grabItem(QPointF)));
-    connect(glscene,SIGNAL(mouseRightButtonPressed(QPointF)),world,SLOT(createBox(QPointF)));
-    connect(glscene,SIGNAL(mouseLeftButtonReleased()),       world,SLOT(dropItem()));
-    connect(glscene,SIGNAL(mouseMoved(QPointF)),             world,SLOT(moveItem(QPointF)));
-    connect(glscene,SIGNAL(keyPressed(int)),                 world,SLOT(handleKeyPressed(int)));
-    connect(glscene,SIGNAL(keyReleased(int)),                world,SLOT(handleKeyReleased(int)));
-
-    connect(world,SIGNAL(itemCreated(QBox2DItem*)),  glscene,SLOT(addItem(QBox2DItem*)));
-    connect(world,SIGNAL(itemDestroyed(QBox2DItem*)),glscene,SLOT(removeItem(QBox2DItem*)));
-    connect(world,SIGNAL(gameFinished()), this, SLOT(restartGame()));
-    connect(glscene,SIGNAL(initialized()),world,SLOT(populate()));
-}
-
-void MainWindow::createQScene(){
-    QScene *scene = new QScene(this);
-    //scene->setItemIndexMethod(QGraphicsScene::NoIndex);
-    //scene->setBackgroundBrush(Qt::white);
-    //scene->setStickyFocus(false);
-
-    QBox2DView *view = new QBox2DView(ui->frameR);
-    view->setScene(scene);
-    //view->fitInView(QRectF(0,0,100,100),Qt::KeepAspectRatioByExpanding);
-    ui->frameR->layout()->addWidget(view);
-
-    connect(timer,SIGNAL(timeout()),scene,SLOT(advance()));
-
-    connect(ui->actionZoomIn,  SIGNAL(triggered()), view, SLOT(zoomIn()));
-    connect(ui->actionZoomOut, SIGNAL(triggered()), view, SLOT(zoomOut()));
-
-    connect(view,SIGNAL(mouseLeftButtonPressed(QPointF)), world,SLOT(grabItem(QPointF)));
-    connect(view,SIGNAL(mouseRightButtonPressed(QPointF)),world,SLOT(createBox(QPointF)));
-    connect(view,SIGNAL(mouseLeftButtonReleased()),       world,SLOT(dropItem()));
-    connect(view,SIGNAL(mouseMoved(QPointF)),             world,SLOT(moveItem(QPointF)));
-    connect(view,SIGNAL(keyPressed(int)),                 world,SLOT(handleKeyPressed(int)));
-    connect(view,SIGNAL(keyReleased(int)),                world,SLOT(handleKeyReleased(int)));
-
-    connect(world,SIGNAL(itemCreated(QBox2DItem*)),  scene,SLOT(addItem(QBox2DItem*)));
-    connect(world,SIGNAL(itemDestroyed(QBox2DItem*)),scene,SLOT(removeItem(QBox2DItem*)));
+    // Input goes through the physics thread's command queue, the world
+    // lives on that thread.
+    connect(glscene,SIGNAL(mouseLeftButtonPressed(QPointF)), physics,SLOT(grabItem(QPointF)));
+    connect(glscene,SIGNAL(mouseRightButtonPressed(QPointF)),physics,SLOT(createBox(QPointF)));
+    connect(glscene,SIGNAL(mouseLeftButtonReleased()),       physics,SLOT(dropItem()));
+    connect(glscene,SIGNAL(mouseMoved(QPointF)),             physics,SLOT(moveItem(QPointF)));
+    connect(glscene,SIGNAL(keyPressed(int)),                 physics,SLOT(handleKeyPressed(int)));
+    connect(glscene,SIGNAL(keyReleased(int)),                physics,SLOT(handleKeyReleased(int)));
+    connect(glscene,SIGNAL(viewChanged(QRectF)),             physics,SLOT(setView(QRectF)));
+
+    glscene->setSnapshots(physics->snapshots(), physics->clock());
 }
 
 void MainWindow::createWorld(){
     qDebug()<<"Creating World";
     //world = new TestWorld(this);
     //world = new ExampleWorld(this);
-    world = new ArcanoidWorld(this);
-    world->setSettings(1.0f / 60.0f, 10, 10);
+    // No parent, the world moves to the physics thread.
+    world = new ArcanoidWorld();
+    world->setSettings(1.0f / PHYSICS_RATE, 10, 10);
     world->_levels_dir = LEVELS_DIR;
-
-    qDebug()<<"Connecting timer with World";
-    connect(timer,SIGNAL(timeout()),world,SLOT(step()));
+    physics = new PhysicsThread(world, this);
+    connect(physics,SIGNAL(gameFinished()), this, SLOT(restartGame()));
 
     qDebug()<<"Connecting world with sound";
     connect(world,SIGNAL(hit()),sound,SLOT(play()));
 }
 
 void MainWindow::deleteWorld(){
-    glscene->clear();
-    world->disconnect();
-    delete world;
-    world = NULL;
+    if (glscene) glscene->clear();
+    if (physics) {
+        physics->stop();
+        delete physics;
+        physics = NULL;
+    }
+    if (world) {
+        world->disconnect();
+        delete world;
+        world = NULL;
+    }
 }
 
 void MainWindow::deleteGLScene(){
@@ -106,21 +94,34 @@ void MainWindow::deleteGLScene(){
 void MainWindow::startGame(){
     createWorld();
     createGLScene();
+    physics->start();
+    connect(timer,SIGNAL(timeout()),this,SLOT(tick()));
     timer->start();
     //_music->play();
 }
 
 void MainWindow::restartGame(){
-    timer->disconnect();
-    timer->stop();
-    deleteWorld();
-    deleteGLScene();
-    startGame();
+    // The world goes back to how populate left it, the scene keeps its
+    // context, textures and shaders. Nothing is loaded or compiled again.
+    physics->restart();
+}
+
+void MainWindow::tick(){
+    b2TraceZone("MainWindow::tick");
+    glscene->updateGL();
+}
+
+void MainWindow::saveTrace(){
+    if (b2TraceExport("qbox2d-trace.json")){
+        qDebug()<<"Trace saved to qbox2d-trace.json";
+    } else {
+        qDebug()<<"Trace not saved";
+    }
 }
 
 MainWindow::~MainWindow(){
     delete timer;
-    delete world;
+    deleteWorld();
     delete ui;
     delete sound;
 }
@@ -6,6 +6,7 @@
 
 class QBox2DWorld;
 class GLScene;
+class PhysicsThread;
 
 namespace Phonon {
     class MediaObject;
@@ -24,15 +25,17 @@ public slots:
     void deleteWorld();
     void createGLScene();
     void deleteGLScene();
-    void createQScene();
     void startGame();
     void restartGame();
+    void tick();
+    void saveTrace();
 
 private:
     Ui::MainWindow *ui;
     GLScene        *glscene;
     QTimer         *timer;
     QBox2DWorld    *world;
+    PhysicsThread  *physics;
     QSound         *sound;
     QMediaPlayer   *player;
 };
@@ -0,0 +1,148 @@
+#include "offscreenrenderer.h"
+#include <QDebug>
+#include <cstring>
+
+OffscreenRenderer::OffscreenRenderer() :
+    _fbo(NULL),
+    _next(0),
+    _pending(0)
+{
+    for (int i = 0; i < RingSize; ++i) {
+        _pixelBuffers[i] = QOpenGLBuffer(QOpenGLBuffer::PixelPackBuffer);
+    }
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+    // The renderer and atlas free their GL objects in this context.
+    if (_context.isValid()) {
+        _context.makeCurrent(&_surface);
+        for (int i = 0; i < RingSize; ++i) {
+            _pixelBuffers[i].destroy();
+        }
+        delete _fbo;
+        _fbo = NULL;
+    }
+}
+
+bool OffscreenRenderer::initialize(const QSize &size, const QString &shaderDir, const QString &textureDir){
+    _size = size;
+
+    // Same context as GLScene asks for, see GLBatchRenderer::initialize.
+    QSurfaceFormat format;
+    format.setVersion(3, 3);
+    format.setProfile(QSurfaceFormat::CompatibilityProfile);
+    _surface.setFormat(format);
+    _context.setFormat(format);
+
+    _surface.create();
+    if (!_context.create() || !_context.makeCurrent(&_surface)) {
+        qDebug() << "Cannot create an offscreen GL context";
+        return false;
+    }
+
+    _fbo = new QOpenGLFramebufferObject(size, QOpenGLFramebufferObject::CombinedDepthStencil);
+    if (!_fbo->isValid()) {
+        qDebug() << "Cannot create a" << size << "framebuffer";
+        return false;
+    }
+
+    // A frame of tightly packed RGBA bytes per slot. StreamRead, the GPU
+    // writes and the CPU reads each frame once.
+    const int bytes = size.width() * size.height() * 4;
+    for (int i = 0; i < RingSize; ++i) {
+        _pixelBuffers[i].setUsagePattern(QOpenGLBuffer::StreamRead);
+        if (!_pixelBuffers[i].create()) {
+            qDebug() << "Cannot create pixel buffers";
+            return false;
+        }
+        _pixelBuffers[i].bind();
+        _pixelBuffers[i].allocate(bytes);
+        _pixelBuffers[i].release();
+    }
+
+    // Same state and view as GLScene, the view scaled with the height so
+    // a capture frames the world like the 640x480 window does.
+    glClearColor(0, 0, 0, 1);
+    glEnable(GL_TEXTURE_2D);
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glViewport(0, 0, size.width(), size.height());
+
+    _camera.setUpDirection(QVector3D(0, -1, 0));
+    _camera.setPosition(QVector3D(0, 0, -20));
+    _camera.projMatrix().ortho(-size.width(), size.width(), -size.height(), size.height(), 0.1, 10000);
+    _camera.lookAt(QVector3D(0, 0, 0));
+    _camera.viewMatrix().scale(20.0 / WORLD_SCALE_FACTOR * size.height() / 480.0);
+
+    if (!_renderer.initialize(shaderDir)) {
+        qDebug() << "Cannot initialize the renderer";
+        return false;
+    }
+    _atlas.build(textureDir);
+    _atlas.finishLoading();
+    return true;
+}
+
+QRectF OffscreenRenderer::visibleRect() const {
+    return _camera.visibleRect();
+}
+
+QImage OffscreenRenderer::render(const WorldSnapshot &snapshot){
+    b2TraceZone("OffscreenRenderer::render");
+    _context.makeCurrent(&_surface);
+    _fbo->bind();
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    _renderer.begin(_camera.viewMatrix(), _camera.projMatrix());
+    _commandBuilder.build(snapshot, 1.0f, _atlas, _renderer);
+    if (_atlas.loading() > 0) {
+        // Frames must not show placeholders, wait for the new textures.
+        _atlas.finishLoading();
+        _renderer.begin(_camera.viewMatrix(), _camera.projMatrix());
+        _commandBuilder.build(snapshot, 1.0f, _atlas, _renderer);
+    }
+    _renderer.draw();
+
+    // Into the pixel buffer, the call returns before the copy is done.
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    _pixelBuffers[_next].bind();
+    glReadPixels(0, 0, _size.width(), _size.height(), GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    _pixelBuffers[_next].release();
+    _fbo->release();
+    _next = (_next + 1) % RingSize;
+
+    if (_pending < RingSize - 1) {
+        ++_pending;
+        return QImage();
+    }
+    // The slot after the newest one holds the oldest frame.
+    return readBack((_next + RingSize - _pending - 1) % RingSize);
+}
+
+QImage OffscreenRenderer::takePending(){
+    if (_pending == 0) return QImage();
+    _context.makeCurrent(&_surface);
+    QImage image = readBack((_next + RingSize - _pending) % RingSize);
+    --_pending;
+    return image;
+}
+
+QImage OffscreenRenderer::readBack(int slot){
+    b2TraceZone("OffscreenRenderer::readBack");
+    // Maps once the copy into this slot is done, which it normally is by
+    // now; the driver waits otherwise.
+    QImage image(_size, QImage::Format_RGBA8888);
+    _pixelBuffers[slot].bind();
+    const void *pixels = _pixelBuffers[slot].mapRange(0, image.byteCount(), QOpenGLBuffer::RangeRead);
+    if (pixels) {
+        memcpy(image.bits(), pixels, image.byteCount());
+        _pixelBuffers[slot].unmap();
+    } else {
+        qDebug() << "Cannot map pixel buffer" << slot;
+        image.fill(Qt::black);
+    }
+    _pixelBuffers[slot].release();
+    return image;
+}
@@ -0,0 +1,68 @@
+#ifndef OFFSCREENRENDERER_H
+#define OFFSCREENRENDERER_H
+
+#include <QImage>
+#include <QOffscreenSurface>
+#include <QOpenGLBuffer>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QRectF>
+#include <QSize>
+#include <QVector>
+#include "items.h"
+#include "glcamera.h"
+#include "glbatchrenderer.h"
+#include "glcommandbuilder.h"
+#include "gltextureatlas.h"
+
+// GLScene's drawing without a window: the same renderer, atlas and
+// command builder draw into a framebuffer object of an offscreen surface,
+// which also works on Mesa's software rasterizer. Frames are read back
+// through a ring of pixel buffer objects, so glReadPixels only queues the
+// copy and the CPU picks the pixels up RingSize - 1 frames later, while
+// the GPU works on newer ones.
+class OffscreenRenderer
+{
+public:
+    OffscreenRenderer();
+    ~OffscreenRenderer();
+
+    // Create the context and framebuffer and load shaders and textures.
+    bool initialize(const QSize &size, const QString &shaderDir, const QString &textureDir);
+
+    QSize size() const { return _size; }
+
+    // World rectangle the frames show, for QBox2DWorld::snapshot.
+    QRectF visibleRect() const;
+
+    // Draw a snapshot at its current poses and start reading it back.
+    // Returns the frame drawn RingSize - 1 calls ago, a null image while
+    // the ring fills. Images are bottom row first, mirror them to save.
+    QImage render(const WorldSnapshot &snapshot);
+
+    // Frames still being read back, oldest first, a null image when none
+    // are left.
+    QImage takePending();
+
+    // Counts of the last render().
+    const GLBatchRenderer& renderer() const { return _renderer; }
+
+    enum { RingSize = 3 };
+
+private:
+    QImage readBack(int slot);
+
+    QSize                     _size;
+    QOffscreenSurface         _surface;
+    QOpenGLContext            _context;
+    QOpenGLFramebufferObject* _fbo;
+    QOpenGLBuffer             _pixelBuffers[RingSize];
+    int                       _next;        // slot the next frame goes to
+    int                       _pending;     // frames queued, not read yet
+    GLCamera                  _camera;
+    GLBatchRenderer           _renderer;
+    GLTextureAtlas            _atlas;
+    GLCommandBuilder          _commandBuilder;
+};
+
+#endif // OFFSCREENRENDERER_H
@@ -1,7 +1,10 @@
 #include "physicitem.h"
+#include <QVector>
 
 PhysicItem::PhysicItem() :
-    _body(NULL)
+    _body(NULL),
+    _previousPosition(0.0f, 0.0f),
+    _previousRotation(0.0f)
 {
 }
 
@@ -19,12 +22,76 @@ void PhysicItem::createBody(b2World *const world){
     _bd.allowSleep = true;
     _bd.awake = true;
     _body = world->CreateBody(&_bd);
+    storePreviousTransform();
+}
+
+void PhysicItem::storePreviousTransform(){
+    if (!_body) return;
+    _previousPosition = _body->GetPosition();
+    _previousRotation = _body->GetAngle();
+}
+
+void PhysicItem::storeState(){
+    if (!_body) return;
+    _storedBody.position = _body->GetPosition();
+    _storedBody.angle = _body->GetAngle();
+    _storedBody.linearVelocity = _body->GetLinearVelocity();
+    _storedBody.angularVelocity = _body->GetAngularVelocity();
+    _storedBody.linearDamping = _body->GetLinearDamping();
+    _storedBody.angularDamping = _body->GetAngularDamping();
+    _storedBody.awake = _body->IsAwake();
+}
+
+void PhysicItem::restoreState(){
+    if (!_body) return;
+    // Leaving the broad-phase drops the contacts of the body, coming back
+    // finds those of the stored pose.
+    _body->SetActive(false);
+    _body->SetTransform(_storedBody.position, _storedBody.angle);
+    _body->SetLinearVelocity(_storedBody.linearVelocity);
+    _body->SetAngularVelocity(_storedBody.angularVelocity);
+    _body->SetLinearDamping(_storedBody.linearDamping);
+    _body->SetAngularDamping(_storedBody.angularDamping);
+    _body->SetActive(true);
+    _body->SetAwake(_storedBody.awake);
+    storePreviousTransform();
+}
+
+void PhysicItem::createBodies(b2World *const world,
+                              const QList<PhysicItem*> &items,
+                              const QList<const b2Shape*> &shapes){
+    Q_ASSERT(items.size() == shapes.size());
+    if (items.isEmpty()) return;
+
+    QVector<b2BodyDef>    bodyDefs(items.size());
+    QVector<b2FixtureDef> fixtureDefs(items.size());
+    QVector<b2Body*>      bodies(items.size());
+
+    for (int i = 0; i < items.size(); ++i) {
+        PhysicItem *item = items.at(i);
+        Q_ASSERT(!item->_body);
+        item->_bd.allowSleep = true;
+        item->_bd.awake = true;
+        item->_fd.shape = shapes.at(i);
+        bodyDefs[i] = item->_bd;
+        fixtureDefs[i] = item->_fd;
+    }
+
+    world->CreateBodies(bodyDefs.constData(), bodyDefs.size(),
+                        fixtureDefs.constData(), NULL, bodies.data());
+
+    for (int i = 0; i < items.size(); ++i) {
+        items.at(i)->_body = bodies.at(i);
+        items.at(i)->storePreviousTransform();
+        items.at(i)->shapeChanged();
+    }
 }
 
 void PhysicItem::setShape(const b2Shape &s ){
     if(!_body) return;
     _fd.shape = &s;
     _body->CreateFixture(&_fd);
+    shapeChanged();
 }
 
 void PhysicItem::setUserData(void *data){
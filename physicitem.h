@@ -2,6 +2,7 @@
 #define PHYSICITEM_H
 #include "def.h"
 #include <Box2D.h>
+#include <QList>
 
 class PhysicItem
 {
@@ -18,17 +19,41 @@ public:
             void setUserData   (void *data);
             void createBody    (b2World *const world);
 
+            // Creates bodies for all items in one b2World::CreateBodies call,
+            // each with a single fixture of the matching shape.
+            static void createBodies(b2World *const world,
+                                     const QList<PhysicItem*> &items,
+                                     const QList<const b2Shape*> &shapes);
+
             b2Body*    body()     const { return _body; }
             b2BodyType bodyType() const { return _body->GetType(); }
             b2Vec2     position() const { return _body->GetPosition(); }
             float32    rotation() const { return _body->GetAngle(); }
 
+            // Body pose before the last step, renderers interpolate from it
+            // to the current pose. Call storePreviousTransform before each step.
+            void       storePreviousTransform();
+            b2Vec2     previousPosition() const { return _previousPosition; }
+            float32    previousRotation() const { return _previousRotation; }
+
+            // Remember the state of the item and bring it back, see
+            // QBox2DWorld::storeInitialState. Subclasses with state of
+            // their own extend both.
+            virtual void storeState();
+            virtual void restoreState();
 
+protected:
+            // Called once the body has its fixture, after setShape or
+            // createBodies. Shapes do not change afterwards.
+            virtual void shapeChanged() {}
 
 private:
             b2Body*      _body;
             b2FixtureDef _fd;
             b2BodyDef    _bd;
+            b2Vec2       _previousPosition;
+            float32      _previousRotation;
+            b2BodyDef    _storedBody;       // pose, velocities and damping
 };
 
 #endif // PHYSICITEM_H
@@ -0,0 +1,160 @@
+#include "physicsthread.h"
+#include "world.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+
+PhysicsThread::PhysicsThread(QBox2DWorld *world, QObject *parent) :
+    QThread(parent),
+    _world(world),
+    _gameFinished(0),
+    _steps(0),
+    _maxCatchUpSteps(5),
+    _populated(false)
+{
+    _clock.start();
+    _world->moveToThread(this);
+    // Direct, the world emits from this thread in the middle of a step.
+    connect(_world, SIGNAL(gameFinished()), this, SLOT(finishGame()), Qt::DirectConnection);
+}
+
+PhysicsThread::~PhysicsThread()
+{
+    stop();
+}
+
+void PhysicsThread::stop(){
+    requestInterruption();
+    wait();
+}
+
+void PhysicsThread::restart(){
+    stop();
+    // run() handed the world back to this thread when it ended.
+    _world->moveToThread(this);
+    _gameFinished.storeRelease(0);
+
+    // Input queued for the finished game must not reach the restored one,
+    // only the latest view still applies. The loop is stopped, so this
+    // thread may consume.
+    WorldCommand command;
+    while (_commands.pop(&command)) {
+        if (command.type == WorldCommand::SetView) _view = command.rect;
+    }
+    // Snapshots count steps from the start of the game. The accumulator
+    // starts empty in run(), and restoreInitialState sets the previous
+    // poses to the restored ones, so the first frame does not interpolate
+    // from the old game.
+    _steps = 0;
+    start();
+}
+
+void PhysicsThread::pushCommand(WorldCommand::Type type, const QPointF &point, int key){
+    WorldCommand command;
+    command.type = type;
+    command.point = point;
+    command.key = key;
+    if (!_commands.push(command)) {
+        qWarning() << "Physics command queue full, dropping command" << type;
+    }
+}
+
+void PhysicsThread::setView(const QRectF &view){
+    WorldCommand command;
+    command.type = WorldCommand::SetView;
+    command.key = 0;
+    command.rect = view;
+    if (!_commands.push(command)) {
+        qWarning() << "Physics command queue full, dropping view" << view;
+    }
+}
+
+void PhysicsThread::grabItem(const QPointF &p)          { pushCommand(WorldCommand::GrabItem, p); }
+void PhysicsThread::moveItem(const QPointF &p)          { pushCommand(WorldCommand::MoveItem, p); }
+void PhysicsThread::dropItem()                          { pushCommand(WorldCommand::DropItem); }
+void PhysicsThread::createBox(const QPointF &p)         { pushCommand(WorldCommand::CreateBox, p); }
+void PhysicsThread::handleKeyPressed(const int &key)    { pushCommand(WorldCommand::KeyPressed, QPointF(), key); }
+void PhysicsThread::handleKeyReleased(const int &key)   { pushCommand(WorldCommand::KeyReleased, QPointF(), key); }
+
+void PhysicsThread::finishGame(){
+    _gameFinished.storeRelease(1);
+}
+
+void PhysicsThread::processCommands(){
+    WorldCommand command;
+    while (_commands.pop(&command)) {
+        switch (command.type) {
+        case WorldCommand::GrabItem:    _world->grabItem(command.point);          break;
+        case WorldCommand::MoveItem:    _world->moveItem(command.point);          break;
+        case WorldCommand::DropItem:    _world->dropItem();                       break;
+        case WorldCommand::CreateBox:   _world->createBox(command.point);         break;
+        case WorldCommand::KeyPressed:  _world->handleKeyPressed(command.key);    break;
+        case WorldCommand::KeyReleased: _world->handleKeyReleased(command.key);   break;
+        case WorldCommand::SetView:     _view = command.rect;                     break;
+        }
+    }
+}
+
+void PhysicsThread::publish(qint64 time, qint64 timeStep){
+    WorldSnapshot &snapshot = _snapshots.writeBuffer();
+    _world->snapshot(&snapshot, _view);
+    snapshot.step = _steps;
+    snapshot.time = time;
+    snapshot.timeStep = timeStep;
+    _snapshots.publish();
+}
+
+void PhysicsThread::run(){
+    b2TraceSetThreadName("physics");
+    if (_populated) {
+        _world->restoreInitialState();
+    } else {
+        _world->populate();
+        _world->storeInitialState();
+        _populated = true;
+    }
+
+    const qint64 timeStep = qMax<qint64>(1, qint64(_world->timeStep() * 1.0e9));
+    qint64 last = _clock.nsecsElapsed();
+    qint64 accumulator = 0;
+    publish(last, timeStep);
+
+    while (!isInterruptionRequested()) {
+        qint64 now = _clock.nsecsElapsed();
+        accumulator += now - last;
+        last = now;
+
+        int steps = 0;
+        while (accumulator >= timeStep && steps < _maxCatchUpSteps) {
+            processCommands();
+            _world->step();
+            ++_steps;
+            ++steps;
+            accumulator -= timeStep;
+            if (_gameFinished.loadAcquire()) break;
+        }
+
+        if (accumulator >= timeStep) {
+            // Too far behind, keep only the fraction of a step.
+            accumulator %= timeStep;
+        }
+
+        if (steps > 0) {
+            // The current poses belong to the time the accumulator has
+            // consumed up to, the renderer interpolates from there.
+            publish(now - accumulator, timeStep);
+        }
+
+        if (_gameFinished.loadAcquire()) {
+            emit gameFinished();
+            break;
+        }
+
+        qint64 wait = timeStep - accumulator - (_clock.nsecsElapsed() - now);
+        if (wait > 0) {
+            usleep(wait / 1000);
+        }
+    }
+
+    // Hand the world back so its owner can delete it.
+    _world->moveToThread(QCoreApplication::instance()->thread());
+}
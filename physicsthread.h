@@ -0,0 +1,103 @@
+#ifndef PHYSICSTHREAD_H
+#define PHYSICSTHREAD_H
+
+#include <QThread>
+#include <QPointF>
+#include <QRectF>
+#include <QElapsedTimer>
+#include "commandqueue.h"
+#include "triplebuffer.h"
+#include "items.h"
+
+class QBox2DWorld;
+
+// Input for the world, queued by the GUI thread.
+struct WorldCommand {
+    enum Type { GrabItem, MoveItem, DropItem, CreateBox, KeyPressed, KeyReleased, SetView };
+
+    Type    type;
+    QPointF point;
+    int     key;
+    QRectF  rect;
+};
+
+// Steps a QBox2DWorld on its own thread, so slow painting and physics no
+// longer hold each other up. The world must have no parent; it is moved to
+// this thread on start and back when the thread ends. GUI input arrives
+// through the slots below, which only queue commands, and after stepping
+// the items are published as a WorldSnapshot that the GUI thread reads
+// through snapshots() without locking.
+//
+// Stepping follows real time with a fixed step accumulator: elapsed clock()
+// time is added up and consumed in whole world time steps, so the physics
+// rate is 1 / time step whatever the render rate. When the thread falls
+// behind, at most maxCatchUpSteps steps are run at once and the rest of the
+// backlog is dropped; the game slows down instead of stalling further.
+//
+// Once a renderer reports its view with setView, snapshots only hold the
+// items in it, see QBox2DWorld::snapshot.
+//
+// The first run populates the world and stores its state, later runs
+// started by restart() restore that state instead.
+class PhysicsThread : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit PhysicsThread(QBox2DWorld *world, QObject *parent = 0);
+    ~PhysicsThread();
+
+    TripleBuffer<WorldSnapshot>* snapshots() { return &_snapshots; }
+
+    // Time base of WorldSnapshot::time, readable from any thread.
+    const QElapsedTimer* clock() const { return &_clock; }
+
+    void setMaxCatchUpSteps(int steps) { _maxCatchUpSteps = steps; }
+
+    // Ask the loop to end and wait for it.
+    void stop();
+
+    // Run the loop again after the game finished. The world is not
+    // populated again but restored to how populate left it, see
+    // QBox2DWorld::restoreInitialState. Commands still queued are
+    // dropped, apart from the view, and the step count starts over.
+    // Call from the thread that created this.
+    void restart();
+
+public slots:
+    void grabItem(const QPointF &p);
+    void moveItem(const QPointF &p);
+    void dropItem();
+    void createBox(const QPointF &p);
+    void handleKeyPressed(const int &key);
+    void handleKeyReleased(const int &key);
+    // World rectangle to snapshot, a null rectangle snapshots everything.
+    void setView(const QRectF &view);
+
+signals:
+    // The game of the world is over, the loop has stopped.
+    void gameFinished();
+
+protected:
+    void run();
+
+private slots:
+    void finishGame();
+
+private:
+    void pushCommand(WorldCommand::Type type, const QPointF &point = QPointF(), int key = 0);
+    void processCommands();
+    void publish(qint64 time, qint64 timeStep);
+
+    QBox2DWorld*                    _world;
+    CommandQueue<WorldCommand, 256> _commands;
+    TripleBuffer<WorldSnapshot>     _snapshots;
+    QAtomicInt                      _gameFinished;
+    QElapsedTimer                   _clock;
+    QRectF                          _view;
+    qint64                          _steps;
+    int                             _maxCatchUpSteps;
+    bool                            _populated;
+};
+
+#endif // PHYSICSTHREAD_H
@@ -0,0 +1,125 @@
+// Loads parser.xml with the DOM and the stream loader and compares the
+// worlds they build, body by body and joint by joint. Exits with 1 on the
+// first difference. Run from this directory:
+//   ./loadercheck [file]
+#include <QCoreApplication>
+#include <QHash>
+#include <QStringList>
+#include <Box2D.h>
+#include "world.h"
+
+namespace {
+
+// Only the loader, nothing to populate.
+class FixtureWorld : public QBox2DWorld
+{
+public:
+    void populate() {}
+};
+
+// Creation order of the bodies, both loaders create them in file order.
+QHash<const b2Body*,int> bodyIndices(b2World *world) {
+    QHash<const b2Body*,int> indices;
+    int index = 0;
+    for (const b2Body *body = world->GetBodyList(); body; body = body->GetNext()) {
+        indices.insert(body, index++);
+    }
+    return indices;
+}
+
+QString describeShape(const b2Shape *shape) {
+    if (shape->GetType() == b2Shape::e_circle) {
+        return QString("circle %1").arg(shape->m_radius);
+    }
+    if (shape->GetType() == b2Shape::e_polygon) {
+        const b2PolygonShape *polygon = static_cast<const b2PolygonShape*>(shape);
+        QStringList vertices;
+        for (int32 i = 0; i < polygon->m_count; ++i) {
+            vertices << QString("(%1, %2)").arg(polygon->m_vertices[i].x).arg(polygon->m_vertices[i].y);
+        }
+        return "polygon " + vertices.join(" ");
+    }
+    return QString("shape %1").arg(shape->GetType());
+}
+
+QString describeBody(const b2Body *body) {
+    QString text = QString("type %1 at (%2, %3) angle %4")
+                   .arg(body->GetType()).arg(body->GetPosition().x)
+                   .arg(body->GetPosition().y).arg(body->GetAngle());
+    if (body->GetUserData()) {
+        const QBox2DItem *item = static_cast<const QBox2DItem*>(body->GetUserData());
+        text += QString(" name '%1' color %2 texture '%3'")
+                .arg(item->name()).arg(item->color().name()).arg(item->textureName());
+    }
+    for (const b2Fixture *fixture = body->GetFixtureList(); fixture; fixture = fixture->GetNext()) {
+        text += QString(", %1 density %2 friction %3 restitution %4")
+                .arg(describeShape(fixture->GetShape())).arg(fixture->GetDensity())
+                .arg(fixture->GetFriction()).arg(fixture->GetRestitution());
+    }
+    return text;
+}
+
+QString describeJoint(const b2Joint *joint, const QHash<const b2Body*,int> &bodies) {
+    QString text = QString("type %1 bodies %2 %3")
+                   .arg(joint->GetType())
+                   .arg(bodies.value(joint->GetBodyA(), -1))
+                   .arg(bodies.value(joint->GetBodyB(), -1));
+    if (joint->GetType() == e_revoluteJoint) {
+        const b2RevoluteJoint *revolute = static_cast<const b2RevoluteJoint*>(joint);
+        text += QString(" anchor (%1, %2) motor %3 speed %4 torque %5")
+                .arg(revolute->GetAnchorA().x).arg(revolute->GetAnchorA().y)
+                .arg(revolute->IsMotorEnabled()).arg(revolute->GetMotorSpeed())
+                .arg(revolute->GetMaxMotorTorque());
+    }
+    return text;
+}
+
+// The descriptions of the world's gravity, bodies and joints, in order.
+QStringList describeWorld(b2World *world) {
+    QStringList lines;
+    lines << QString("gravity (%1, %2)").arg(world->GetGravity().x).arg(world->GetGravity().y);
+    for (const b2Body *body = world->GetBodyList(); body; body = body->GetNext()) {
+        lines << "body " + describeBody(body);
+    }
+    const QHash<const b2Body*,int> bodies = bodyIndices(world);
+    for (const b2Joint *joint = world->GetJointList(); joint; joint = joint->GetNext()) {
+        lines << "joint " + describeJoint(joint, bodies);
+    }
+    return lines;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    const QString file = a.arguments().value(1, "parser.xml");
+
+    FixtureWorld dom;
+    dom.loadWorld(file, QBox2DWorld::DomLoader);
+    FixtureWorld stream;
+    stream.loadWorld(file, QBox2DWorld::StreamLoader);
+
+    const QStringList domLines = describeWorld(dom._world);
+    const QStringList streamLines = describeWorld(stream._world);
+    // The ground body of the world and at least one object.
+    if (domLines.size() < 3) {
+        qWarning() << "Nothing loaded from" << file;
+        return 1;
+    }
+
+    for (int i = 0; i < qMax(domLines.size(), streamLines.size()); ++i) {
+        const QString domLine = domLines.value(i, "(none)");
+        const QString streamLine = streamLines.value(i, "(none)");
+        if (domLine != streamLine) {
+            qWarning() << "Loaders differ at line" << i;
+            qWarning() << "  DOM:   " << domLine;
+            qWarning() << "  stream:" << streamLine;
+            return 1;
+        }
+    }
+
+    qDebug() << "Loaders agree on" << file << ":" << dom._world->GetBodyCount() << "bodies,"
+             << dom._world->GetJointCount() << "joints";
+    return 0;
+}
@@ -0,0 +1,36 @@
+# Checks that the DOM and the stream level loader build the same world
+# from parser.xml, a file of corner cases of the level format. Build
+# Box2D/Box2D.pro first, then run from this directory:
+#   ./loadercheck
+# It exits with 1 and prints the first difference if the loaders disagree.
+QT       = core gui xml
+
+CONFIG   += console release warn_on
+CONFIG   -= app_bundle
+
+# Must match Box2D/Box2D.pro.
+#DEFINES += B2_TRACE
+
+TARGET = loadercheck
+TEMPLATE = app
+
+SOURCES += loadercheck.cpp \
+           ../items.cpp \
+           ../world.cpp \
+           ../physicitem.cpp \
+           ../contactlistener.cpp
+
+HEADERS += ../items.h \
+           ../def.h \
+           ../world.h \
+           ../physicitem.h \
+           ../contactlistener.h
+
+OTHER_FILES += parser.xml
+
+MOC_DIR = tmp
+OBJECTS_DIR = tmp
+
+INCLUDEPATH += .. ../Box2D
+QMAKE_LIBDIR += $$PWD/../Box2D/lib
+LIBS += -lBox2D
@@ -1,6 +1,8 @@
 #include "texture.h"
 
 #include <QtOpenGL>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions>
 #include <QtGui/QImage>
 
 Texture::Texture(const QString &fileName, bool clamp) :
@@ -25,22 +27,67 @@ bool Texture::load(const QString &fileName, bool clamp)
     if(fileName.isEmpty())
 		return false;
 
-    QImage image, imageGL;
+    // Decoded files come from the cache.
+    CachedTexture texture;
+    if( !TextureCache().load(fileName, &texture) )
+		return false;
+
+    return upload( texture, clamp );
+}
+
+bool Texture::upload(const CachedTexture &texture, bool clamp)
+{
+    if( texture.image.isNull() )
+		return false;
+
+    _width  = texture.image.width();
+    _height = texture.image.height();
+
+    if( !_textureId )
+        glGenTextures( 1, &_textureId );
+
+	enable();
+
+    setParameters( clamp, true );
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, texture.image.constBits() );
+    QOpenGLContext::currentContext()->functions()->glGenerateMipmap(GL_TEXTURE_2D);
+
+	disable();
+
+	return true;
+}
 
-    if( !image.load(fileName) )
+bool Texture::upload(const QImage &image, bool clamp)
+{
+    if( image.isNull() )
 		return false;
 
-    imageGL = QGLWidget::convertToGLFormat(image);
+    QImage imageGL = QGLWidget::convertToGLFormat(image);
 
     _width  = imageGL.width();
     _height = imageGL.height();
 
-    glGenTextures( 1, &_textureId );
+    if( !_textureId )
+        glGenTextures( 1, &_textureId );
 
 	enable();
 
+    setParameters( clamp, false );
+
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, imageGL.constBits() );
+
+	disable();
+
+	return true;
+}
+
+void Texture::setParameters(bool clamp, bool mipmapped)
+{
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
 
     if( clamp )	{
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
@@ -49,13 +96,6 @@ bool Texture::load(const QString &fileName, bool clamp)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 	}
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _width, _height, 0, GL_RGBA,
-                 GL_UNSIGNED_BYTE, imageGL.constBits() );
-
-	disable();
-
-	return true;
 }
 
 Texture *Texture::grab(){
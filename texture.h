@@ -3,6 +3,7 @@
 
 #include <QString>
 #include <QtOpenGL>
+#include "texturecache.h"
 
 class Texture {
 public:
@@ -11,6 +12,13 @@ public:
 
     bool load( const QString &fileName, bool clamp = true );
 
+    // Upload an image decoded elsewhere, e.g. by a TextureLoader on its
+    // threads. The GL context must be current.
+    bool upload( const QImage &image, bool clamp = true );
+
+    // Upload straight from the cache file's mapping and generate the mips.
+    bool upload( const CachedTexture &texture, bool clamp = true );
+
     void enable()  { glBindTexture(GL_TEXTURE_2D, _textureId); }
     void disable() { glBindTexture(GL_TEXTURE_2D, 0); }
 
@@ -24,6 +32,7 @@ public:
 
 protected:
     int refCount() const { return _refCount; }
+    void setParameters( bool clamp, bool mipmapped );
 
 protected:
     int    _refCount;
@@ -0,0 +1,141 @@
+#include "texturecache.h"
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSharedPointer>
+#include <QStandardPaths>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+const char   Magic[8]  = { 'Q', 'B', '2', 'D', 'T', 'E', 'X', 0 };
+const quint32 Version  = 2;
+const int    Alignment = 16;
+
+// Native byte order, the cache never leaves the machine.
+struct Header {
+    char    magic[8];
+    quint32 version;
+    quint32 width;
+    quint32 height;
+    quint32 translucent;
+    quint32 pathBytes;          // UTF-8 source path after the header
+    qint64  sourceModified;     // ms since the epoch
+    qint64  sourceSize;
+    quint64 texelOffset;
+};
+
+qint64 aligned(qint64 offset) {
+    return (offset + Alignment - 1) / Alignment * Alignment;
+}
+
+void unmapImage(void *info) {
+    delete static_cast<QSharedPointer<QFile>*>(info);
+}
+
+bool hasTranslucentPixels(const QImage &rgba) {
+    for (int row = 0; row < rgba.height(); ++row) {
+        const uchar *pixel = rgba.constScanLine(row);
+        for (int column = 0; column < rgba.width(); ++column) {
+            if (pixel[4 * column + 3] < 255) return true;
+        }
+    }
+    return false;
+}
+
+}
+
+TextureCache::TextureCache() :
+    _dir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/textures")
+{
+}
+
+TextureCache::TextureCache(const QString &dir) :
+    _dir(dir)
+{
+}
+
+QString TextureCache::entryPath(const QString &absolutePath) const {
+    const QByteArray hash = QCryptographicHash::hash(absolutePath.toUtf8(), QCryptographicHash::Sha1);
+    return _dir + "/" + QString::fromLatin1(hash.toHex()) + ".tex";
+}
+
+bool TextureCache::load(const QString &path, CachedTexture *texture) const {
+    if (find(path, texture)) return true;
+
+    QImage image(path);
+    if (image.isNull()) return false;
+    store(path, image, texture);
+    return true;
+}
+
+bool TextureCache::find(const QString &path, CachedTexture *texture) const {
+    const QFileInfo source(path);
+    if (!source.exists()) return false;
+
+    QSharedPointer<QFile> file(new QFile(entryPath(source.absoluteFilePath())));
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(Header))) return false;
+    const uchar *data = file->map(0, file->size());
+    if (!data) return false;
+
+    Header header;
+    memcpy(&header, data, sizeof(header));
+    const QByteArray sourcePath = source.absoluteFilePath().toUtf8();
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version ||
+        header.sourceModified != source.lastModified().toMSecsSinceEpoch() ||
+        header.sourceSize != source.size() ||
+        header.pathBytes != quint32(sourcePath.size()) ||
+        sizeof(Header) + header.pathBytes > quint64(file->size()) ||
+        memcmp(data + sizeof(Header), sourcePath.constData(), sourcePath.size()) != 0) {
+        return false;
+    }
+
+    const quint64 bytes = quint64(header.width) * header.height * 4;
+    if (header.width < 1 || header.height < 1 || header.texelOffset + bytes > quint64(file->size())) {
+        return false;
+    }
+    // Read only, the image copies before anything writes to it.
+    texture->image = QImage(data + header.texelOffset, header.width, header.height, header.width * 4,
+                            QImage::Format_RGBA8888, unmapImage, new QSharedPointer<QFile>(file));
+    texture->translucent = header.translucent != 0;
+    return true;
+}
+
+bool TextureCache::store(const QString &path, const QImage &image, CachedTexture *texture) const {
+    // GL order, the rows of a QImage are top first.
+    const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888).mirrored();
+    texture->image = rgba;
+    texture->translucent = hasTranslucentPixels(rgba);
+
+    const QFileInfo source(path);
+    const QByteArray sourcePath = source.absoluteFilePath().toUtf8();
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.width = rgba.width();
+    header.height = rgba.height();
+    header.translucent = texture->translucent;
+    header.pathBytes = sourcePath.size();
+    header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+    header.sourceSize = source.size();
+    header.texelOffset = aligned(sizeof(Header) + sourcePath.size());
+
+    if (!QDir().mkpath(_dir)) return false;
+    // Written aside and renamed, a reader never maps half a file.
+    QSaveFile file(entryPath(source.absoluteFilePath()));
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    const QByteArray zeros(Alignment, 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(sourcePath);
+    file.write(zeros.constData(), header.texelOffset - file.pos());
+    file.write(reinterpret_cast<const char*>(rgba.constBits()), rgba.byteCount());
+    if (!file.commit()) {
+        qDebug() << "Cannot write texture cache" << file.fileName();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <QImage>
+#include <QString>
+
+// A decoded texture, RGBA8888 with the bottom row first, what
+// glTexImage2D and the atlas pages take as GL_RGBA/GL_UNSIGNED_BYTE.
+// Loaded from the cache the image points into the mapped cache file,
+// which stays mapped while it is alive. No mip levels, whoever uploads
+// generates them, the atlas once per page.
+struct CachedTexture {
+    QImage image;
+    bool   translucent;     // has pixels that are not fully opaque
+};
+
+// Decoded textures on disk, so a start does not decode the PNGs again.
+// Each source image gets one file, named after a hash of its path, with a
+// header naming the source's path, modification time and size, then the
+// texels. Entries whose source changed are
+// rebuilt. Files are memory mapped on load, nothing is decoded or copied.
+// Stateless besides the directory, threads may share one.
+class TextureCache
+{
+public:
+    // In the application's cache location.
+    TextureCache();
+    explicit TextureCache(const QString &dir);
+
+    QString dir() const { return _dir; }
+
+    // Texture of the image file at path, decoded and stored first when
+    // the cache has no current entry. False if the file cannot be read.
+    bool load(const QString &path, CachedTexture *texture) const;
+
+    // Only the lookup, false without a current entry.
+    bool find(const QString &path, CachedTexture *texture) const;
+
+    // Convert image, the contents of the file at path, and write it to
+    // the cache. The texture is filled even if writing fails.
+    bool store(const QString &path, const QImage &image, CachedTexture *texture) const;
+
+private:
+    QString entryPath(const QString &absolutePath) const;
+
+    QString _dir;
+};
+
+#endif // TEXTURECACHE_H
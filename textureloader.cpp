@@ -0,0 +1,66 @@
+#include "textureloader.h"
+#include <QRunnable>
+#include <QThread>
+#include <QDebug>
+
+class DecodeJob : public QRunnable
+{
+public:
+    DecodeJob(TextureLoader *loader, const QString &name, const QString &path) :
+        _loader(loader), _name(name), _path(path) {}
+
+    void run(){
+        _loader->finished(TextureLoader::decode(_name, _path, _loader->_cache));
+    }
+
+private:
+    TextureLoader* _loader;
+    QString        _name;
+    QString        _path;
+};
+
+TextureLoader::TextureLoader() :
+    _pending(0)
+{
+    // Leave a core to the GL and physics threads.
+    _pool.setMaxThreadCount(qMax(1, QThread::idealThreadCount() - 1));
+}
+
+TextureLoader::~TextureLoader()
+{
+    _pool.waitForDone();
+}
+
+void TextureLoader::request(const QString &name, const QString &path){
+    _pending.ref();
+    _pool.start(new DecodeJob(this, name, path));
+}
+
+QList<DecodedImage> TextureLoader::takeDecoded(){
+    QMutexLocker locker(&_mutex);
+    QList<DecodedImage> decoded;
+    decoded.swap(_decoded);
+    _pending.fetchAndAddOrdered(-decoded.size());
+    return decoded;
+}
+
+void TextureLoader::finished(const DecodedImage &image){
+    QMutexLocker locker(&_mutex);
+    _decoded.append(image);
+}
+
+DecodedImage TextureLoader::decode(const QString &name, const QString &path, const TextureCache &cache){
+    DecodedImage decoded;
+    decoded.name = name;
+    decoded.translucent = false;
+
+    CachedTexture texture;
+    if (!cache.load(path, &texture)) {
+        qDebug() << "Cannot read texture" << path;
+        return decoded;
+    }
+    // Already in the pages' layout, the atlas copies from the mapping.
+    decoded.image = texture.image;
+    decoded.translucent = texture.translucent;
+    return decoded;
+}
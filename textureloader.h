@@ -0,0 +1,57 @@
+#ifndef TEXTURELOADER_H
+#define TEXTURELOADER_H
+
+#include <QAtomicInt>
+#include <QImage>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+#include "texturecache.h"
+
+// An image decoded off the GL thread, ready to upload.
+struct DecodedImage {
+    QString name;
+    QImage  image;          // RGBA8888 bottom row first, as the cache maps
+                            // it; null if the file could not be read
+    bool    translucent;    // has pixels that are not fully opaque
+};
+
+// Decodes image files on a thread pool, so the GL thread only uploads.
+// request() returns at once; the GL thread collects finished images with
+// takeDecoded() whenever it has time for uploads. Images come from a
+// TextureCache, only files that changed since they were cached are
+// decoded.
+class TextureLoader
+{
+public:
+    TextureLoader();
+    ~TextureLoader();
+
+    // Decode the file at path in the background, reported back as name.
+    void request(const QString &name, const QString &path);
+
+    // Images decoded since the last call, in the order they finished.
+    QList<DecodedImage> takeDecoded();
+
+    // Requests not taken yet.
+    int pending() const { return _pending.load(); }
+
+    // Block until every request is decoded.
+    void waitForDone() { _pool.waitForDone(); }
+
+    // Decode a file on the calling thread, what the workers run.
+    static DecodedImage decode(const QString &name, const QString &path, const TextureCache &cache);
+
+private:
+    friend class DecodeJob;
+    void finished(const DecodedImage &image);
+
+    TextureCache        _cache;
+    QThreadPool         _pool;
+    QMutex              _mutex;
+    QList<DecodedImage> _decoded;
+    QAtomicInt          _pending;
+};
+
+#endif // TEXTURELOADER_H
@@ -0,0 +1,43 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <QAtomicInt>
+
+// Hands the latest value from one writer thread to one reader thread
+// without locks. The writer fills writeBuffer() and calls publish(); the
+// reader calls read() and always gets the newest complete value. Neither
+// side ever waits, a value the reader did not pick up in time is reused
+// by the writer.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() : _middle(1), _front(0), _back(2) {}
+
+    // Writer side.
+    T& writeBuffer() { return _buffers[_back]; }
+
+    void publish() {
+        int old = _middle.fetchAndStoreAcquireRelease(_back | FreshBit);
+        _back = old & IndexMask;
+    }
+
+    // Reader side. The reference stays valid until the next read().
+    const T& read() {
+        if (_middle.loadAcquire() & FreshBit) {
+            int old = _middle.fetchAndStoreAcquireRelease(_front);
+            _front = old & IndexMask;
+        }
+        return _buffers[_front];
+    }
+
+private:
+    enum { IndexMask = 3, FreshBit = 4 };
+
+    T          _buffers[3];
+    QAtomicInt _middle;     // index of the shared slot, FreshBit once published
+    int        _front;      // owned by the reader
+    int        _back;       // owned by the writer
+};
+
+#endif // TRIPLEBUFFER_H
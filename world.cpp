@@ -1,8 +1,15 @@
 #include "world.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <algorithm>
 
 
 QBox2DWorld::QBox2DWorld(QObject* parent): QObject(parent),
-    _mouseJoint(NULL) {
+    _mouseJoint(NULL),
+    _nextAppendIndex(0),
+    _snapshotFrame(0),
+    _coldStart(false) {
     _world = new b2World(b2Vec2(0,0));
 
     b2BodyDef bd;
@@ -112,18 +119,24 @@ void QBox2DWorld::parseXML(const QDomElement &root){
             if(jointNode.attribute("type") == "revolute" ){
                 b2RevoluteJointDef jointDef;
                 QDomElement bodiesNode = jointNode.firstChildElement("bodies");
-                if(!bodiesNode.isNull()){
-                    b2Body* bodyA = findItem( bodiesNode.attribute("a"))->body();
-                    b2Body* bodyB = NULL;
-                    if (bodiesNode.attribute("b") == "_ground" ){
-                        bodyB = _ground;
-                    } else {
-                        bodyB = findItem( bodiesNode.attribute("b"))->body();
-                    }
-                    if( bodyA && bodyB ) {
-                        jointDef.Initialize(bodyA, bodyB, bodyA->GetPosition());
-                    }
+                if(bodiesNode.isNull()){
+                    // Same as the stream loader, a joint needs two bodies.
+                    qWarning() << "Revolute joint without bodies, ignored";
+                    jointNode = jointNode.nextSiblingElement( "joint" );
+                    continue;
                 }
+                QBox2DItem* itemA = findItem( bodiesNode.attribute("a"));
+                QBox2DItem* itemB = findItem( bodiesNode.attribute("b"));
+                b2Body* bodyA = itemA ? itemA->body() : NULL;
+                b2Body* bodyB = (bodiesNode.attribute("b") == "_ground") ? _ground :
+                                itemB ? itemB->body() : NULL;
+                if( !bodyA || !bodyB ) {
+                    qWarning() << "Joint references unknown body:" << bodiesNode.attribute("a")
+                               << bodiesNode.attribute("b");
+                    jointNode = jointNode.nextSiblingElement( "joint" );
+                    continue;
+                }
+                jointDef.Initialize(bodyA, bodyB, bodyA->GetPosition());
 
                 QDomElement motorNode = jointNode.firstChildElement("motor");
                 if(!motorNode.isNull()){
@@ -138,30 +151,249 @@ void QBox2DWorld::parseXML(const QDomElement &root){
     }
 }
 
-void QBox2DWorld::loadWorld(const QString &filename){
+namespace {
+
+// Joint read from the stream; bodies are looked up by name once the whole
+// file has been read, so joints may reference objects defined after them.
+struct PendingJoint {
+    QString type;
+    bool    hasBodies;
+    QString bodyA;
+    QString bodyB;
+    bool    hasMotor;
+    float32 motorSpeed;
+    float32 maxMotorTorque;
+    bool    enableMotor;
+};
+
+float32 attributeFloat(const QXmlStreamAttributes &attributes, const QString &name) {
+    return attributes.value(name).toString().toFloat();
+}
+
+PendingJoint readJoint(QXmlStreamReader &xml) {
+    PendingJoint joint;
+    joint.type = xml.attributes().value("type").toString();
+    joint.hasBodies = false;
+    joint.hasMotor = false;
+    joint.motorSpeed = 0.0f;
+    joint.maxMotorTorque = 0.0f;
+    joint.enableMotor = false;
+
+    // Like firstChildElement in the DOM loader, the first of each child wins.
+    while (xml.readNextStartElement()) {
+        const QXmlStreamAttributes attributes = xml.attributes();
+        if (xml.name() == QLatin1String("bodies") && !joint.hasBodies) {
+            joint.hasBodies = true;
+            joint.bodyA = attributes.value("a").toString();
+            joint.bodyB = attributes.value("b").toString();
+        } else if (xml.name() == QLatin1String("motor") && !joint.hasMotor) {
+            joint.hasMotor = true;
+            joint.motorSpeed = attributeFloat(attributes, "speed");
+            joint.maxMotorTorque = attributeFloat(attributes, "torque");
+            joint.enableMotor = attributes.value("enable") == QLatin1String("true");
+        }
+        xml.skipCurrentElement();
+    }
+    return joint;
+}
+
+}
+
+QBox2DItem* QBox2DWorld::readObject(QXmlStreamReader &xml){
+    QBox2DItem *item = new QBox2DItem();
+    const QXmlStreamAttributes objectAttributes = xml.attributes();
+
+    if (objectAttributes.value("bodyType") == QLatin1String("dynamic")) {
+        item->setBodyType(b2_dynamicBody);
+    }
+
+    if (objectAttributes.hasAttribute("name")) {
+        item->setName(objectAttributes.value("name").toString());
+    }
+
+    // Children may come in any order, but the body has to exist before the
+    // fixture is attached, so the geometry is kept until the object ends.
+    // As with firstChildElement in the DOM loader, a repeated child is
+    // ignored after the first.
+    enum Child { Position = 1, Physic = 2, Geometry = 4, Color = 8, Texture = 16 };
+    int     seen = 0;
+    QString geometryType;
+    float32 width = 0, height = 0, radius = 0;
+    QColor  color = Qt::white;
+
+    while (xml.readNextStartElement()) {
+        const QXmlStreamAttributes attributes = xml.attributes();
+        const int child = xml.name() == QLatin1String("position") ? Position :
+                          xml.name() == QLatin1String("physic")   ? Physic :
+                          xml.name() == QLatin1String("geometry") ? Geometry :
+                          xml.name() == QLatin1String("color")    ? Color :
+                          xml.name() == QLatin1String("texture")  ? Texture : 0;
+        if (!child || (seen & child)) {
+            xml.skipCurrentElement();
+            continue;
+        }
+        seen |= child;
+
+        if (child == Position) {
+            item->setPos(b2Vec2(WSCALE2(attributeFloat(attributes, "x"),
+                                        attributeFloat(attributes, "y"))));
+            if (attributes.hasAttribute("rotation"))
+                item->setRotation(attributeFloat(attributes, "rotation"));
+            xml.skipCurrentElement();
+        } else if (child == Physic) {
+            item->setDensity(attributeFloat(attributes, "density"));
+            item->setFriction(attributeFloat(attributes, "friction"));
+            item->setRestitution(attributeFloat(attributes, "restitution"));
+            xml.skipCurrentElement();
+        } else if (child == Geometry) {
+            geometryType = attributes.value("type").toString();
+            width  = attributeFloat(attributes, "width");
+            height = attributeFloat(attributes, "height");
+            radius = attributeFloat(attributes, "radius");
+            xml.skipCurrentElement();
+        } else if (child == Color) {
+            color = QColor(xml.readElementText());
+        } else {
+            item->setTextureName(xml.readElementText());
+        }
+    }
+
+    item->createBody(_world);
+    item->body()->SetUserData(item);
+
+    if (geometryType == "box") {
+        b2PolygonShape shape;
+        shape.SetAsBox(WSCALE2(width/2, height/2));
+        item->setShape(shape);
+    } else if (geometryType == "circle") {
+        b2CircleShape circle;
+        circle.m_radius = WSCALE(radius);
+        item->setShape(circle);
+    }
+
+    item->setColor(color);
+    return item;
+}
+
+void QBox2DWorld::parseXMLStream(QXmlStreamReader &xml){
+    QHash<QString, QBox2DItem*> namedItems;
+    QList<PendingJoint> joints;
+    // Only the first gravity, objects and joints element counts, as in
+    // the DOM loader.
+    bool gravitySeen = false, objectsSeen = false, jointsSeen = false;
+
+    while (xml.readNextStartElement()) {
+        if (xml.name() == QLatin1String("gravity") && !gravitySeen) {
+            gravitySeen = true;
+            const QXmlStreamAttributes attributes = xml.attributes();
+            if (attributes.hasAttribute("strength")) {
+                _world->SetGravity(b2Vec2(attributeFloat(attributes, "direction"),
+                                          attributeFloat(attributes, "strength")));
+            }
+            xml.skipCurrentElement();
+        } else if (xml.name() == QLatin1String("objects") && !objectsSeen) {
+            objectsSeen = true;
+            while (xml.readNextStartElement()) {
+                if (xml.name() != QLatin1String("object")) {
+                    xml.skipCurrentElement();
+                    continue;
+                }
+                QBox2DItem *item = readObject(xml);
+                // findItem returns the newest body of a name, so a later
+                // object replaces an earlier one of the same name.
+                if (!item->name().isEmpty())
+                    namedItems.insert(item->name(), item);
+                appendItem(item);
+            }
+        } else if (xml.name() == QLatin1String("joints") && !jointsSeen) {
+            jointsSeen = true;
+            while (xml.readNextStartElement()) {
+                if (xml.name() == QLatin1String("joint"))
+                    joints.append(readJoint(xml));
+                else
+                    xml.skipCurrentElement();
+            }
+        } else {
+            xml.skipCurrentElement();
+        }
+    }
+
+    if (xml.hasError()) {
+        qDebug() << "XML error:" << xml.errorString() << "at line" << xml.lineNumber();
+    }
+
+    // The DOM loader stops at a file without objects, before its joints.
+    if (!objectsSeen) return;
+
+    // Second pass: every object is known now, resolve joint bodies by name.
+    // Joints without two known bodies are reported and left out, as in
+    // the DOM loader.
+    foreach (const PendingJoint &joint, joints) {
+        if (joint.type != "revolute") continue;
+
+        if (!joint.hasBodies) {
+            qWarning() << "Revolute joint without bodies, ignored";
+            continue;
+        }
+
+        QBox2DItem *itemA = namedItems.value(joint.bodyA);
+        QBox2DItem *itemB = namedItems.value(joint.bodyB);
+        b2Body *bodyA = itemA ? itemA->body() : NULL;
+        b2Body *bodyB = (joint.bodyB == "_ground") ? _ground :
+                        itemB ? itemB->body() : NULL;
+        if (!bodyA || !bodyB) {
+            qWarning() << "Joint references unknown body:" << joint.bodyA << joint.bodyB;
+            continue;
+        }
+
+        b2RevoluteJointDef jointDef;
+        jointDef.Initialize(bodyA, bodyB, bodyA->GetPosition());
+        if (joint.hasMotor) {
+            jointDef.motorSpeed = joint.motorSpeed;
+            jointDef.maxMotorTorque = joint.maxMotorTorque;
+            jointDef.enableMotor = joint.enableMotor;
+        }
+        _world->CreateJoint(&jointDef);
+    }
+}
+
+void QBox2DWorld::loadWorld(const QString &filename, XmlLoader loader){
     qDebug() << "In loadworld";
-    QDomDocument domDoc("world");
     QFile file(filename);
     if (!file.open(QIODevice::ReadOnly)){
         qDebug() << "XML file not found";
         return;
     }
-    if (!domDoc.setContent(&file)) {
-        qDebug() << "Cannot set file content";
-        file.close();
-        return;
-    }
-    file.close();
-    qDebug() << "Reading XML file";
 
-    QDomElement root = domDoc.documentElement();
-    if (root.tagName() != "world") {
-        qDebug() << "Not a world file";
-        return;
-    }
+    QElapsedTimer loadTimer;
+    loadTimer.start();
+
+    if (loader == StreamLoader) {
+        QXmlStreamReader xml(&file);
+        if (!xml.readNextStartElement() || xml.name() != QLatin1String("world")) {
+            qDebug() << "Not a world file";
+            return;
+        }
+        qDebug() << "Reading XML file";
+        parseXMLStream(xml);
+    } else {
+        QDomDocument domDoc("world");
+        if (!domDoc.setContent(&file)) {
+            qDebug() << "Cannot set file content";
+            return;
+        }
+        qDebug() << "Reading XML file";
+
+        QDomElement root = domDoc.documentElement();
+        if (root.tagName() != "world") {
+            qDebug() << "Not a world file";
+            return;
+        }
 
-    parseXML(root);
+        parseXML(root);
+    }
 
+    qDebug() << "World loaded in" << loadTimer.elapsed() << "ms";
 }
 
 void QBox2DWorld::setSettings(float32 timeStep, int32 velIters, int32 posIters){
@@ -183,14 +415,19 @@ void QBox2DWorld::handleKeyReleased(const int &key)
 }
 
 void QBox2DWorld::step(){
-    for(b2Body *body = _world->GetBodyList(); body; body = body->GetNext()) {
-        if (body->GetUserData() != NULL) {
-            QBox2DItem *item = static_cast<QBox2DItem*>(body->GetUserData());
-            item->update();
-        }
+    b2TraceZone("QBox2DWorld::step");
+    for (int i = 0; i < _items.size(); ++i) {
+        _items.at(i)->update();
     }
 
+    // Every joint zeroes its accumulated impulses when a step does not
+    // warm start. Joints of bodies restored asleep keep theirs until they
+    // wake; populate leaves none asleep.
+    const bool warmStarting = _world->GetWarmStarting();
+    if (_coldStart) _world->SetWarmStarting(false);
     _world->Step(_timeStep,_velocityIterations,_positionIterations);
+    _world->SetWarmStarting(warmStarting);
+    _coldStart = false;
 }
 
 QBox2DItem* QBox2DWorld::createBox(const QPointF& pos) {
@@ -268,23 +505,133 @@ void QBox2DWorld::moveItem(const QPointF &p){
 void QBox2DWorld::destroyItem(QBox2DItem *item)
 {
     for (b2JointEdge* edge = item->body()->GetJointList(); edge; edge = edge->next) {
-        if (edge->joint == _mouseJoint)
-            _mouseJoint = NULL;
+        if (edge->joint == _mouseJoint) {
+            dropItem();
+            break;
+        }
     }
 
-    _world->DestroyBody(item->body());
+    _items.removeOne(item);
+    _bodilessItems.removeOne(item);
     emit itemDestroyed(item);
+
+    if (_keptItems.contains(item)) {
+        // Out of the broad-phase and the solver, restoreInitialState
+        // brings it back.
+        item->body()->SetActive(false);
+        return;
+    }
+    _world->DestroyBody(item->body());
     delete item;
     item = NULL;
 }
 
 void QBox2DWorld::appendItem(QBox2DItem *item){
+    item->_appendIndex = _nextAppendIndex++;
+    _items.append(item);
+    if (!item->body()) _bodilessItems.append(item);
     emit itemCreated(item);
 }
 
+void QBox2DWorld::storeInitialState(){
+    _initialItems = _items;
+    _initialBodilessItems = _bodilessItems;
+    _keptItems = _items.toSet();
+    _initialGravity = _world->GetGravity();
+    for (int i = 0; i < _items.size(); ++i) {
+        _items.at(i)->storeState();
+    }
+}
+
+void QBox2DWorld::restoreInitialState(){
+    b2TraceZone("QBox2DWorld::restoreInitialState");
+    dropItem();
+
+    QSet<QBox2DItem*> present;
+    foreach (QBox2DItem *item, _items) {
+        if (_keptItems.contains(item)) {
+            present.insert(item);
+        } else {
+            destroyItem(item);
+        }
+    }
+
+    _items = _initialItems;
+    _bodilessItems = _initialBodilessItems;
+    _world->SetGravity(_initialGravity);
+    _coldStart = true;
+    for (int i = 0; i < _items.size(); ++i) {
+        QBox2DItem *item = _items.at(i);
+        item->restoreState();
+        if (!present.contains(item)) emit itemCreated(item);
+    }
+
+    initialStateRestored();
+}
+
+namespace {
+
+void copyItem(RenderItem &r, QBox2DItem *item) {
+    r.modelMatrix        = item->modelMatrix();
+    r.color              = item->color();
+    r.textureName        = item->textureName();
+    r.vertices           = item->vertices();
+    r.textureCoordinates = item->_textureCoordinates;
+    r.hasBody            = item->body() != NULL;
+    if (r.hasBody) {
+        r.previousPosition = item->previousPosition();
+        r.previousRotation = item->previousRotation();
+        r.position         = item->position();
+        r.rotation         = item->rotation();
+    }
+}
+
+bool appendedBefore(const QBox2DItem *a, const QBox2DItem *b) {
+    return a->_appendIndex < b->_appendIndex;
+}
+
+}
+
+void QBox2DWorld::snapshot(WorldSnapshot *snapshot, const QRectF &view) const {
+    // resize keeps the capacity, so the buffer stops allocating once the
+    // item count settles.
+    if (view.isNull()) {
+        snapshot->items.resize(_items.size());
+        for (int i = 0; i < _items.size(); ++i) {
+            copyItem(snapshot->items[i], _items.at(i));
+        }
+        snapshot->culled = 0;
+        return;
+    }
+
+    // Items without a body are not in the tree and always drawn. Items
+    // given a body after they were appended are in the tree.
+    _visibleItems.resize(0);
+    for (int i = 0; i < _bodilessItems.size(); ++i) {
+        if (!_bodilessItems.at(i)->body()) _visibleItems.append(_bodilessItems.at(i));
+    }
+
+    b2AABB aabb;
+    aabb.lowerBound.Set(float32(view.left()),  float32(view.top()));
+    aabb.upperBound.Set(float32(view.right()), float32(view.bottom()));
+    ViewQueryCallback callback(&_visibleItems, ++_snapshotFrame);
+    _world->QueryAABB(&callback, aabb);
+
+    // In the order the items were appended, as without a view, so equal
+    // depths draw the same way every run.
+    std::sort(_visibleItems.begin(), _visibleItems.end(), appendedBefore);
+
+    snapshot->items.resize(_visibleItems.size());
+    for (int i = 0; i < _visibleItems.size(); ++i) {
+        copyItem(snapshot->items[i], _visibleItems.at(i));
+    }
+    snapshot->culled = _items.size() - _visibleItems.size();
+}
+
 QBox2DItem* QBox2DWorld::findItem(const QString &itemName){
     for(b2Body *body = _world->GetBodyList(); body; body = body->GetNext()) {
-        if (body->GetUserData() != NULL) {
+        // Inactive bodies belong to destroyed items kept for a restore.
+        if (body->GetUserData() != NULL && body->IsActive()) {
             QBox2DItem *item = static_cast<QBox2DItem*>(body->GetUserData());
             if (item->name() == itemName){
                 return item;
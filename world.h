@@ -3,8 +3,11 @@
 
 #include <Box2D.h>
 #include <QObject>
+#include <QRectF>
+#include <QVector>
 #include <QSet>
 #include <QDomDocument>
+#include <QXmlStreamReader>
 #include "items.h"
 #include "contactlistener.h"
 
@@ -24,16 +27,55 @@ private:
     int32                   _velocityIterations;
     int32                   _positionIterations;
     b2MouseJoint*           _mouseJoint;
+    QList<QBox2DItem*>      _items;
+    QList<QBox2DItem*>      _bodilessItems;     // not in the broad-phase
+    int                     _nextAppendIndex;
+    mutable int             _snapshotFrame;
+    mutable QVector<QBox2DItem*> _visibleItems; // snapshot's view query
+
+    // State storeInitialState recorded, see restoreInitialState.
+    QList<QBox2DItem*>      _initialItems;
+    QList<QBox2DItem*>      _initialBodilessItems;
+    QSet<QBox2DItem*>       _keptItems;
+    b2Vec2                  _initialGravity;
+    bool                    _coldStart;     // next step without warm starting
 
 public:
+    enum XmlLoader { DomLoader, StreamLoader };
+
     explicit QBox2DWorld(QObject* parent = 0);
     virtual ~QBox2DWorld();
 
             void setSettings(float32 timeStep, int32 velIters, int32 posIters);
+         float32 timeStep() const { return _timeStep; }
             void destroyItem(QBox2DItem *item);
             void appendItem(QBox2DItem *item);
-            void loadWorld(const QString &filename);
+            // Both loaders read the first of repeated elements, let a
+            // later object replace an earlier one of the same name in
+            // joints and skip joints with missing bodies. They must build
+            // the same world, tests/loadercheck.pro checks that.
+            void loadWorld(const QString &filename, XmlLoader loader = StreamLoader);
      QBox2DItem* findItem(const QString &itemName);
+            // Copy items for a renderer. With a view rectangle in world
+            // units, only bodies whose fixtures overlap it are copied,
+            // found through the broad-phase, plus every item without a body.
+            void snapshot(WorldSnapshot *snapshot, const QRectF &view = QRectF()) const;
+
+            // Record the items as they are, usually right after populate.
+            // From then on destroyItem only takes those items out of the
+            // world, their bodies and joints stay inactive.
+            void storeInitialState();
+            // Back to the recorded state without loading the level again:
+            // items created since are destroyed, recorded ones come back
+            // with their poses, velocities, colors and textures. Contacts
+            // are rebuilt and the next step does not warm start, which
+            // clears the joints' impulses, motor impulses included.
+            void restoreInitialState();
+
+protected:
+            // Called at the end of restoreInitialState, for worlds that
+            // keep pointers to items.
+    virtual void initialStateRestored() {}
 
 public slots:
     virtual void step();
@@ -55,6 +97,8 @@ signals:
 
 private:
             void parseXML(const QDomElement &root);
+            void parseXMLStream(QXmlStreamReader &xml);
+     QBox2DItem* readObject(QXmlStreamReader &xml);
 };
 
 
@@ -86,4 +130,28 @@ public:
     b2Fixture* _fixture;
 };
 
+// Collects the items of the bodies in an AABB, each once however many
+// of its fixtures overlap: an item is stamped with the frame when it is
+// first reported.
+class ViewQueryCallback : public b2QueryCallback
+{
+public:
+    ViewQueryCallback(QVector<QBox2DItem*> *items, int frame) : _items(items), _frame(frame) {}
+
+    bool ReportFixture(b2Fixture* fixture){
+        void *data = fixture->GetBody()->GetUserData();
+        if (data) {
+            QBox2DItem *item = static_cast<QBox2DItem*>(data);
+            if (item->_visibleFrame != _frame) {
+                item->_visibleFrame = _frame;
+                _items->append(item);
+            }
+        }
+        return true;
+    }
+
+    QVector<QBox2DItem*>* _items;
+    int                   _frame;
+};
+
 #endif // WORLD_H
@@ -1,5 +1,6 @@
 #include "arcanoidworld.h"
 #include "brick.h"
+#include <cmath>
 
 ArcanoidWorld::ArcanoidWorld(QObject *parent) : QBox2DWorld(parent) {
     _contactListener = new QBox2DContactListener();
@@ -15,14 +16,15 @@ ArcanoidWorld::~ArcanoidWorld() {
 
 void ArcanoidWorld::step(){
     QBox2DWorld::step();
-    _sky->modelMatrix().rotate(0.05,QVector3D(0,1,0));
+    // 3 degrees per second whatever the physics rate.
+    _sky->modelMatrix().rotate(3.0f * timeStep(),QVector3D(0,1,0));
     //_sky->modelMatrix().rotate(0.3,QVector3D(1,0,0));
 
     if (!_ball || !_paddle || !_bound) return;
 
     adjustBallSpeed();
 
-    QList<ContactPoint> &_contacts = _contactListener->_contacts;
+    QVector<ContactPoint> &_contacts = _contactListener->_contacts;
 
     if (_contacts.size() == 0) {
         return;
@@ -59,7 +61,7 @@ void ArcanoidWorld::step(){
         destroyItem(item);
     }
 
-    if (!findItem("brick")) {
+    if (!findItem(QStringLiteral("brick"))) {
         emit gameFinished();
     }
 
@@ -117,6 +119,7 @@ void ArcanoidWorld::populate() {
     shape.SetAsBox(WSCALE2(1,1));
     horItem->setShape(shape);
     horItem->setColor(gray);
+    horItem->body()->SetUserData(horItem);
     appendItem(horItem);
 
     b2PrismaticJointDef horJointDef;
@@ -141,6 +144,11 @@ void ArcanoidWorld::populate() {
     float32 brickWidth = 2;
     int xStep = fieldSize/n;
     int yStep = fieldSize/n;
+    b2PolygonShape brickShape;
+    brickShape.SetAsBox(WSCALE2(brickWidth,brickWidth/2));
+
+    QList<PhysicItem*>     bricks;
+    QList<const b2Shape*>  brickShapes;
     for (int j = 0; j < n-1; ++j){
         for (int i = 0; i < n; ++i){
             Brick* brick = new Brick();
@@ -151,29 +159,41 @@ void ArcanoidWorld::populate() {
             brick->setFriction(0);
             brick->setDensity(10.0f);
             brick->setBodyType(b2_dynamicBody);
-            brick->createBody(_world);
-            b2PolygonShape brickShape;
-            brickShape.SetAsBox(WSCALE2(brickWidth,brickWidth/2));
-            brick->setShape(brickShape);
-            //brick->setColor(QColor(128 + qrand() % 128, 128 + qrand() % 128, 128 + qrand() % 128));
-            brick->setColor(Qt::white);
-            brick->body()->SetUserData(brick);
-            brick->setName("brick");
-            brick->setDurability(qrand() % 3);
-            appendItem(brick);
-
-            b2RevoluteJointDef jointDef;
-            jointDef.Initialize(brick->body(), _ground, brick->body()->GetWorldCenter());
-            jointDef.enableMotor = true;
-            jointDef.motorSpeed = pow(-1.0f,i+j) * (qrand() % 100) / 10;
-            jointDef.maxMotorTorque = 5000.0f;
-            _world->CreateJoint(&jointDef);
+            bricks << brick;
+            brickShapes << &brickShape;
         }
     }
 
+    // The whole grid goes into the broad-phase in one batch.
+    PhysicItem::createBodies(_world, bricks, brickShapes);
+
+    for (int k = 0; k < bricks.size(); ++k){
+        int i = k % n;
+        int j = k / n;
+        Brick* brick = static_cast<Brick*>(bricks.at(k));
+        //brick->setColor(QColor(128 + qrand() % 128, 128 + qrand() % 128, 128 + qrand() % 128));
+        brick->setColor(Qt::white);
+        brick->body()->SetUserData(brick);
+        brick->setName("brick");
+        brick->setDurability(qrand() % 3);
+        appendItem(brick);
+
+        b2RevoluteJointDef jointDef;
+        jointDef.Initialize(brick->body(), _ground, brick->body()->GetWorldCenter());
+        jointDef.enableMotor = true;
+        jointDef.motorSpeed = pow(-1.0f,i+j) * (qrand() % 100) / 10;
+        jointDef.maxMotorTorque = 5000.0f;
+        _world->CreateJoint(&jointDef);
+    }
+
 }
 
 
+void ArcanoidWorld::initialStateRestored(){
+    // The ball may have been replaced since populate.
+    _ball = findItem("ball");
+}
+
 void ArcanoidWorld::handleKeyPressed(const int &key)
 {
     switch( key ) {
@@ -23,6 +23,7 @@ public:
 private:
     void createBall(float32 radius);
     void adjustBallSpeed();
+    void initialStateRestored();
 };
 
 